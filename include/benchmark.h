@@ -0,0 +1,32 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       benchmark.h
+* Description: Benchmarks of the stages of the measurement pipeline on a synthetic deflation: conversion of the raw counts (one count per
+* call, size 1, and the whole deflation in one call of the block kernel of pressure_conversion.h), the running mean
+* (normalize), the cuff pressure/oscillation filter (filter), the per sample analysis one reading per call (process_sample) and in blocks of
+* PROCESS_BLOCK_SIZE (process_block), the systolic/diastolic and pulse calculators and a complete session. Every stage runs for each sample type, the running mean for several window
+* lengths, the filter one reading and 32 readings per call, and the systolic/diastolic calculator for several OMWE graph sizes: the
+* envelope crossings (bp_calculator) and the nearest point search (bp_calculator_scan). Time is read with hal_bench_ticks(): CPU cycles from the DWT cycle counter on the target, nanoseconds on the host.
+* Every result is the fastest of BENCH_REPEATS runs, which filters out interrupts and scheduling noise.
+*/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#define BENCH_SESSION_SAMPLES 4000      // Length of the synthetic deflation (80 s at 50 Hz)
+#define BENCH_REPEATS 5                 // Runs per result, the fastest one is reported
+
+// One benchmark result, reported as one CSV line: stage,sample_type,size,calls,ticks_per_call
+struct BENCH_RESULT {
+    const char *stage;
+    const char *sample_type;
+    unsigned long size;             // Window length, OMWE points or samples per session, depending on the stage
+    unsigned long calls;            // Calls timed per run
+    double ticks_per_call;          // Fastest run divided by calls, in the unit of hal_bench_unit()
+};
+
+typedef void (*BENCH_REPORT)(const BENCH_RESULT &result);
+
+void run_benchmarks(BENCH_REPORT report);    // Runs all stages
+
+#endif
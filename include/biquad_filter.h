@@ -0,0 +1,271 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       biquad_filter.h
+* Description: Cascade of second order IIR sections (biquads) in direct form I, processed a block of samples at a time. Coefficients and
+* state use the layout of the CMSIS-DSP arm_biquad_cascade_df1 functions: {b0, b1, b2, a1, a2} per section with
+*
+*   y[n] = b0 * x[n] + b1 * x[n-1] + b2 * x[n-2] + a1 * y[n-1] + a2 * y[n-2]
+*
+* (a1, a2 of the usual transfer function with inverted sign) and {x[n-1], x[n-2], y[n-1], y[n-2]} per section. A block runs through the
+* first section completely before the second one, so the state of a section stays in registers and the cost of a block is bounded by
+* Stages * 5 multiply-adds per sample, independent of the sample rate.
+*
+*   float    the loop in plain C++, or arm_biquad_cascade_df1_f32 of CMSIS-DSP with -DBP_USE_CMSIS_DSP=1 (see below)
+*   double   plain C++
+*   Q16.16   coefficients in Q2.30 and a 64 bit accumulator, like arm_biquad_cascade_df1_q31 with a post shift of 1. The Q15 functions
+*            are not used: a 0.5 Hz low-pass at 500 Hz has 1 - a1 - a2 = 4e-5, below the resolution of Q15 coefficients.
+*   counts   the same on the raw sensor counts (count_t)
+*
+* The low-pass numerator is recomputed from the rounded a1, a2 so the DC gain of every section is exactly 1 in the sample type. Cuff pressures
+* are four orders of magnitude above the pressure oscillations, so a DC gain error of a few 1e-3 from rounded coefficients would shift the
+* pressures by more than the filter resolves.
+*
+* BP_USE_CMSIS_DSP is off by default: mbed OS only ships the CMSIS core headers, and platformio.ini does not add CMSIS-DSP. To use its
+* kernel, put the CMSIS-DSP headers and library (with ARM_MATH_CM4 for the disco_f429zi) on the build path and add -DBP_USE_CMSIS_DSP=1.
+* The native_cmsis_dsp environment builds and tests that path on the host against the reference arm_math.h of test/cmsis_dsp_reference.
+*/
+
+#ifndef BIQUAD_FILTER_H
+#define BIQUAD_FILTER_H
+
+#include <math.h>
+#include <stdint.h>
+#include "sample_types.h"
+
+#ifndef BP_USE_CMSIS_DSP
+#define BP_USE_CMSIS_DSP 0
+#endif
+
+#if BP_USE_CMSIS_DSP
+#include "arm_math.h"
+#endif
+
+// One section, designed in double precision
+struct BIQUAD_SECTION {
+    double b0, b1, b2;
+    double a1, a2;          // Sign as used by CMSIS-DSP: y[n] = ... + a1 * y[n-1] + a2 * y[n-2]
+    bool lowpass;           // DC gain 1, the numerator is fitted to the rounded denominator
+};
+
+/***Functions to design the sections*****
+Butterworth type sections by the bilinear transform (RBJ audio EQ cookbook). q = 0.7071 gives a second order Butterworth filter, the
+sections of a higher order one use the q values of its pole pairs. */
+
+inline BIQUAD_SECTION biquad_design(double cutoff_hz, double q, double rate_hz, bool lowpass) {
+    double w0 = 2.0 * M_PI * cutoff_hz / rate_hz;
+    double alpha = sin(w0) / (2.0 * q);
+    double one_minus_cos = 2.0 * sin(w0 / 2.0) * sin(w0 / 2.0);     // 1 - cos(w0) without the cancellation at low cutoff frequencies
+    double a0 = 1.0 + alpha;
+    BIQUAD_SECTION section;
+    section.b0 = (lowpass ? one_minus_cos : 2.0 - one_minus_cos) / 2.0 / a0;
+    section.b1 = (lowpass ? 2.0 * section.b0 : -2.0 * section.b0);
+    section.b2 = section.b0;
+    section.a1 = 2.0 * (1.0 - one_minus_cos) / a0;
+    section.a2 = -(1.0 - alpha) / a0;
+    section.lowpass = lowpass;
+    return section;
+}
+
+inline BIQUAD_SECTION biquad_lowpass(double cutoff_hz, double q, double rate_hz) {
+    return biquad_design(cutoff_hz, q, rate_hz, true);
+}
+
+inline BIQUAD_SECTION biquad_highpass(double cutoff_hz, double q, double rate_hz) {
+    return biquad_design(cutoff_hz, q, rate_hz, false);
+}
+
+// Output of a section in steady state for the constant input value (used to start without a transient)
+inline double biquad_dc_gain(const BIQUAD_SECTION &section) {
+    return section.lowpass ? 1.0 : 0.0;
+}
+
+// Floating-point samples (double, float): coefficients, state and their setup, shared by the plain C++ and the CMSIS-DSP kernel
+template <typename T, int Stages>
+class FloatBiquadCascade {
+    static_assert(Stages > 0, "BiquadCascade needs at least one section");
+
+public:
+    FloatBiquadCascade() {
+        for (int i = 0; i < 5 * Stages; i++){
+            coefficients[i] = T(0);
+        }
+        for (int stage = 0; stage < Stages; stage++){
+            gains[stage] = T(0);
+        }
+        reset(T(0));
+    }
+
+    void configure(const BIQUAD_SECTION *sections) {
+        for (int stage = 0; stage < Stages; stage++){
+            T *section = coefficients + 5 * stage;
+            section[3] = T(sections[stage].a1);
+            section[4] = T(sections[stage].a2);
+            if (sections[stage].lowpass){
+                T b0 = (T(1) - section[3] - section[4]) / T(4);      // b0 + b1 + b2 == 1 - a1 - a2 in T
+                section[0] = b0;
+                section[1] = T(1) - section[3] - section[4] - b0 - b0;
+                section[2] = b0;
+            }
+            else {
+                section[0] = T(sections[stage].b0);
+                section[1] = -(section[0] + section[0]);
+                section[2] = section[0];
+            }
+            gains[stage] = T(biquad_dc_gain(sections[stage]));
+        }
+        reset(T(0));
+    }
+
+    // State of a cascade that has seen the constant input value forever
+    void reset(T value) {
+        for (int stage = 0; stage < Stages; stage++){
+            T output = value * gains[stage];
+            state[4 * stage] = value;
+            state[4 * stage + 1] = value;
+            state[4 * stage + 2] = output;
+            state[4 * stage + 3] = output;
+            value = output;
+        }
+    }
+
+protected:
+    T coefficients[5 * Stages];
+    T state[4 * Stages];
+    T gains[Stages];
+};
+
+template <typename T, int Stages>
+class BiquadCascade : public FloatBiquadCascade<T, Stages> {
+public:
+    // Filters count samples, output may be the input buffer
+    void process(const T *input, T *output, int count) {
+        for (int stage = 0; stage < Stages; stage++){
+            const T *section = this->coefficients + 5 * stage;
+            T *history = this->state + 4 * stage;
+            T b0 = section[0], b1 = section[1], b2 = section[2], a1 = section[3], a2 = section[4];
+            T x1 = history[0], x2 = history[1], y1 = history[2], y2 = history[3];
+            for (int i = 0; i < count; i++){
+                T x0 = input[i];
+                T y0 = b0 * x0 + b1 * x1 + b2 * x2 + a1 * y1 + a2 * y2;
+                x2 = x1;
+                x1 = x0;
+                y2 = y1;
+                y1 = y0;
+                output[i] = y0;
+            }
+            history[0] = x1;
+            history[1] = x2;
+            history[2] = y1;
+            history[3] = y2;
+            input = output;
+        }
+    }
+};
+
+#if BP_USE_CMSIS_DSP
+// Single precision on the target: the CMSIS-DSP kernel, which is unrolled and scheduled for the Cortex-M4F FPU
+template <int Stages>
+class BiquadCascade<float, Stages> : public FloatBiquadCascade<float, Stages> {
+public:
+    // The instance only points to the members, it is set up for every call so a copied cascade does not use the state of the original.
+    // arm_biquad_cascade_df1_init_f32() is not used as it clears the state. CMSIS-DSP before 1.7 takes the input as float32_t *, it does
+    // not write to it.
+    void process(const float *input, float *output, int count) {
+        arm_biquad_casd_df1_inst_f32 instance;
+        instance.numStages = Stages;
+        instance.pState = this->state;
+        instance.pCoeffs = this->coefficients;
+        arm_biquad_cascade_df1_f32(&instance, const_cast<float *>(input), output, (uint32_t)count);
+    }
+};
+#endif
+
+// Fixed-point samples (q16_16_t, count_t) with Q2.30 coefficients (|a1| < 2), products summed in 64 bit and rounded once per output
+template <typename Fixed, int Stages>
+class FixedBiquadCascade {
+    static_assert(Stages > 0, "BiquadCascade needs at least one section");
+
+public:
+    FixedBiquadCascade() {
+        for (int i = 0; i < 5 * Stages; i++){
+            coefficients[i] = 0;
+        }
+        for (int stage = 0; stage < Stages; stage++){
+            unity_gain[stage] = false;
+        }
+        reset(Fixed(0));
+    }
+
+    void configure(const BIQUAD_SECTION *sections) {
+        for (int stage = 0; stage < Stages; stage++){
+            int32_t *section = coefficients + 5 * stage;
+            section[3] = to_q30(sections[stage].a1);
+            section[4] = to_q30(sections[stage].a2);
+            if (sections[stage].lowpass){
+                int64_t sum = ((int64_t)1 << 30) - section[3] - section[4];   // b0 + b1 + b2 in Q2.30
+                section[0] = (int32_t)(sum / 4);
+                section[1] = (int32_t)(sum - 2 * (sum / 4));
+                section[2] = section[0];
+            }
+            else {
+                section[0] = to_q30(sections[stage].b0);
+                section[1] = -2 * section[0];
+                section[2] = section[0];
+            }
+            unity_gain[stage] = biquad_dc_gain(sections[stage]) == 1.0;
+        }
+        reset(Fixed(0));
+    }
+
+    void reset(Fixed value) {
+        for (int stage = 0; stage < Stages; stage++){
+            Fixed output = unity_gain[stage] ? value : Fixed(0);
+            state[4 * stage] = value.raw();
+            state[4 * stage + 1] = value.raw();
+            state[4 * stage + 2] = output.raw();
+            state[4 * stage + 3] = output.raw();
+            value = output;
+        }
+    }
+
+    void process(const Fixed *input, Fixed *output, int count) {
+        for (int stage = 0; stage < Stages; stage++){
+            const int32_t *section = coefficients + 5 * stage;
+            int32_t *history = state + 4 * stage;
+            int64_t b0 = section[0], b1 = section[1], b2 = section[2], a1 = section[3], a2 = section[4];
+            int32_t x1 = history[0], x2 = history[1], y1 = history[2], y2 = history[3];
+            for (int i = 0; i < count; i++){
+                int32_t x0 = input[i].raw();
+                int64_t sum = b0 * x0 + b1 * x1 + b2 * x2 + a1 * y1 + a2 * y2;     // Samples below 2^29 (Q16.16: 8192 mmHg, counts: 2^25), at most 2^60 per product
+                int32_t y0 = (int32_t)((sum + ((int64_t)1 << 29)) >> 30);
+                x2 = x1;
+                x1 = x0;
+                y2 = y1;
+                y1 = y0;
+                output[i] = Fixed::from_raw(y0);
+            }
+            history[0] = x1;
+            history[1] = x2;
+            history[2] = y1;
+            history[3] = y2;
+            input = output;
+        }
+    }
+
+private:
+    static int32_t to_q30(double value) {
+        return (int32_t)floor(value * (double)((int64_t)1 << 30) + 0.5);
+    }
+
+    int32_t coefficients[5 * Stages];
+    int32_t state[4 * Stages];
+    bool unity_gain[Stages];        // DC gain of the section, 1 or 0
+};
+
+template <int Stages>
+class BiquadCascade<q16_16_t, Stages> : public FixedBiquadCascade<q16_16_t, Stages> {};
+
+template <typename Sensor, int FracBits, int Stages>
+class BiquadCascade<SensorCounts<Sensor, FracBits>, Stages> : public FixedBiquadCascade<SensorCounts<Sensor, FracBits>, Stages> {};
+
+#endif
@@ -0,0 +1,80 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       bp_config.h
+* Description: Sensor constants, thresholds of the Maximum Amplitude Algorithm (MAA) and build time configuration shared by the target
+* firmware and the host build. Every setting guarded by #ifndef can be overridden from build_flags in platformio.ini.
+*/
+
+#ifndef BP_CONFIG_H
+#define BP_CONFIG_H
+
+#include "mpr_sensor.h"
+
+// The given sensor (MPRLS0300YG) follows transfer function B as per datasheet: output from 2.5% (419430) to 22.5% (3774873) of the 24 bit
+// range over 0 - 300 mmHg. Other parts of the MPR series are selected with the three settings below (see mpr_sensor.h).
+#ifndef MPR_TRANSFER_FUNCTION
+#define MPR_TRANSFER_FUNCTION MPR_TRANSFER_B   // MPR_TRANSFER_A, MPR_TRANSFER_B or MPR_TRANSFER_C
+#endif
+#ifndef MPR_PRESSURE_RANGE
+#define MPR_PRESSURE_RANGE 300                  // Full scale pressure in MPR_PRESSURE_UNIT, the range starts at 0
+#endif
+#ifndef MPR_PRESSURE_UNIT
+#define MPR_PRESSURE_UNIT MPR_UNIT_MMHG         // MPR_UNIT_MMHG, MPR_UNIT_PSI, MPR_UNIT_KPA, MPR_UNIT_MBAR or MPR_UNIT_BAR
+#endif
+typedef MprSensor<MPR_TRANSFER_FUNCTION, 0, MPR_PRESSURE_RANGE, MPR_PRESSURE_UNIT> CuffSensor;   // Sensor of the cuff
+
+#define OUTPUT_MAX ((double)CuffSensor::output_max())   // Maximum value of 24 bit output from sensor
+#define OUTPUT_MIN CuffSensor::output_min()              // Minimum value of 24 bit output from sensor
+#define PRESSURE_MAX CuffSensor::pressure_max()          // Maximum possible pressure that could be measured (mmHg)
+#define PRESSURE_MIN CuffSensor::pressure_min()          // Minimum possible pressure that could be measured (mmHg)
+#define MIN_OMWE_THRESH 70.0   // Minimum OMWE graph filter for checking MAP values (helps to eradicate edge noices)
+#define MAX_OMWE_THRESH 160.0  // Maximum OMWE graph filter for checking MAP values (helps to eradicate edge noices)
+#define MAP_ERROR_THRESH 0.5   // Maximum supported error threshold while calculating the pressure position at Systolic and Diastolic pressure points in OMWE graph
+#define SYSTOLIC_LOWER_CHAR_RATIO 0.45  // Lower bound of Rs
+#define SYSTOLIC_UPPER_CHAR_RATIO 0.73  // Upper bound of Rs 
+#define DIASTOLIC_LOWER_CHAR_RATIO 0.69 // Lower bound of Rd
+#define DIASTOLIC_UPPER_CHAR_RATIO 0.83 // Upper bound of Rd
+#define MAP_SEARCH_MAX 110.0            // Highest normalized pressure accepted as MAP
+#define SYSTOLIC_SEARCH_MIN 100.0       // Range of pressures (mmHg) accepted as systolic pressure
+#define SYSTOLIC_SEARCH_MAX 200.0
+#define DIASTOLIC_SEARCH_MIN 50.0       // Range of pressures (mmHg) accepted as diastolic pressure
+#define DIASTOLIC_SEARCH_MAX 90.0
+#define ENVELOPE_BIN_WIDTH 4.0          // Pressure span (mmHg, about one heart beat of the deflation) merged into one envelope point, 0: nearest graph point
+#define LOWER_PULSE_RANGE 35.0          // Minimum practical pulse (bpm)
+#define UPPER_PULSE_RANGE 150.0         // Maximum practical pulse (bpm)
+#define BEAT_REFRACTORY_MS ((unsigned long)(60000.0 / UPPER_PULSE_RANGE))   // Oscillation maxima closer than this are one heart beat, the larger is kept
+#define PULSE_AMPLITUDE_RATIO 0.5       // Only beats whose oscillation reaches this fraction of the MAP amplitude are timed for the pulse
+#define CALIBRATION_SAMPLES 100         // Number of readings at 0 mmHg averaged by auto_caliberate()
+#ifndef SAMPLE_RATE_HZ
+#define SAMPLE_RATE_HZ 50               // Ticker driven sampling rate of the MPR sensor (50 - 500 Hz), can be overridden with -DSAMPLE_RATE_HZ in build_flags
+#endif
+#define INFLATION_PRESSURE 200.0        // Cuff pressure (mmHg) at which the red LED asks to release the pressure
+#define MIN_RELEASE_RATE 2.0            // Slowest release (mmHg per second) for which the OMWE graph holds the whole deflation
+#define OMWE_MAX_POINT_RATE 50          // Most OMWE graph points per second: above it the graph keeps the largest peak of every OMWE_DECIMATION readings
+#define OMWE_DECIMATION ((SAMPLE_RATE_HZ + OMWE_MAX_POINT_RATE - 1) / OMWE_MAX_POINT_RATE)
+#define BEAT_BUFFER_SIZE ((long)((INFLATION_PRESSURE - MIN_OMWE_THRESH) / MIN_RELEASE_RATE * UPPER_PULSE_RANGE / 60.0) + 1)   // Heart beats of the slowest release at the highest pulse
+#ifndef OMWE_BUFFER_SIZE
+#define OMWE_BUFFER_SIZE ((long)((INFLATION_PRESSURE - MIN_OMWE_THRESH) / MIN_RELEASE_RATE * OMWE_MAX_POINT_RATE))   // Points of the OMWE graph and the OMWE time buffer
+#endif
+#ifndef MPR_ACQUISITION_MODE
+#define MPR_ACQUISITION_MODE MPR_WAIT_BUSY_POLL   // How the end of a conversion is detected: MPR_WAIT_FIXED, MPR_WAIT_EOC or MPR_WAIT_BUSY_POLL
+#endif
+#define MPR_POLL_BACKOFF_US 250         // Delay between two status polls while the sensor reports busy
+#ifndef MPR_PIPELINED
+#define MPR_PIPELINED 1                 // 1: start the next conversion right after reading the previous one, so the sensor converts between ticks
+#endif
+#ifndef NORMALIZE_WINDOW
+#define NORMALIZE_WINDOW 5              // Number of latest readings averaged into the normalized pressure (PRESSURE_FILTER_MEAN), can be raised with the sample rate
+#endif
+#ifndef PROCESS_BLOCK_SIZE
+#define PROCESS_BLOCK_SIZE 32           // Most readings run through each stage of process_pressure_block() at once
+#endif
+#define CUFF_LOWPASS_HZ 0.5             // Cutoff of the cuff pressure low-pass (PRESSURE_FILTER_BIQUAD, see oscillometric_filter.h)
+#define OSCILLATION_LOW_HZ 0.5          // Pass band of the oscillation band-pass, covers 30 - 300 bpm
+#define OSCILLATION_HIGH_HZ 5.0
+
+static_assert(SAMPLE_RATE_HZ >= 50 && SAMPLE_RATE_HZ <= 500, "SAMPLE_RATE_HZ must be in the range 50 - 500 Hz");
+static_assert(OMWE_BUFFER_SIZE >= (INFLATION_PRESSURE - MIN_OMWE_THRESH) / MIN_RELEASE_RATE * SAMPLE_RATE_HZ / OMWE_DECIMATION,
+              "OMWE_BUFFER_SIZE does not hold the graph points of a release from INFLATION_PRESSURE to MIN_OMWE_THRESH at SAMPLE_RATE_HZ");
+
+#endif
@@ -0,0 +1,33 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       bp_hal.h
+* Description: Hardware abstraction used by the MPR acquisition code. The target firmware implements it in src/main.cpp on top of the mbed
+* SPI, Timer and InterruptIn drivers. The host build implements it in src/host/sim_hal.cpp with a simulated MPR sensor and a virtual clock,
+* where waiting only advances the simulated time, so a complete cuff deflation runs as fast as the CPU allows.
+*/
+
+#ifndef BP_HAL_H
+#define BP_HAL_H
+
+#include <stdint.h>
+
+// One chip select framed SPI exchange with the MPR sensor: length bytes of command are sent while length bytes of response are received.
+// Returns false if the transfer was rejected, failed or did not complete in time, the response is not valid then.
+bool mpr_spi_exchange(const char *command, char *response, int length);
+
+// Microseconds since the start of the measurement, the time base of all sample timestamps
+unsigned long hal_now_us();
+
+// Busy or sleeping delay of the acquisition context
+void hal_wait_us(unsigned long delay_us);
+
+// End of conversion signal of the sensor (MPR_WAIT_EOC): hal_eoc_arm() forgets an earlier edge before a conversion is started and
+// hal_eoc_wait() returns once the EOC pin rose or after timeout_us
+void hal_eoc_arm();
+void hal_eoc_wait(unsigned long timeout_us);
+
+// Free running counter for the benchmarks (see benchmark.h), wraps around: CPU cycles on the target, nanoseconds on the host
+uint32_t hal_bench_ticks();
+const char *hal_bench_unit();
+
+#endif
@@ -0,0 +1,161 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       bp_monitor.h
+* Description: Measurement algorithm of the Blood Pressure and Pulse Monitoring system (Maximum Amplitude Algorithm, see src/bp_algorithm.cpp).
+* The algorithm only consumes raw, timestamped sensor samples and has no hardware dependency, so the same code runs on the target and in
+* the host build. All state of one measurement lives in a MeasurementSession object: there are no globals, so several sessions can run
+* side by side (one per thread on the host) and reset() prepares a session for the next measurement without a reboot. The methods of one
+* session must be called from a single context at a time. The session is instantiated for double, float, q16_16_t and count_t (sample_types.h).
+*/
+
+#ifndef BP_MONITOR_H
+#define BP_MONITOR_H
+
+#include "bp_config.h"
+#include "oscillometric_filter.h"
+#include "pressure_conversion.h"
+#include "sample_types.h"
+
+// Structure Containing parameters related to BP like Systolic and Diastolic BPs and parameters related MAA algorithm for BP estimation
+struct BP_PARAMETER {
+    double systolic_bloodpressure;
+    double diastolic_bloodpressure;
+    double systolic_char_ratio;
+    double diastolic_char_ratio;
+};
+
+// Structure containing pulse value and the number of data points using which the pulse was evaluated
+struct PULSE_READING {
+    double pulse_value;
+    long pulse_data_count;
+};
+
+// Structure containing one raw reading of the MPR sensor as handed from the acquisition thread to the processing loop
+struct PRESSURE_SAMPLE {
+    unsigned long timestamp_us;     // Time the conversion was started relative to the start of the measurement (us)
+    unsigned long conversion_us;    // Time between starting the conversion and reading its output (us)
+    long pressure_data;             // Concatenated 24 bit output of the sensor
+    char status;                    // Status byte returned with the reading
+};
+
+// Tunable parameters of the MAA algorithm. maa_default_parameters() returns the values of bp_config.h, other values are only used by the
+// host tools (program sweep) to tune them against reference readings.
+struct MAA_PARAMETERS {
+    double systolic_lower_ratio;     // Bounds of Rs
+    double systolic_upper_ratio;
+    double diastolic_lower_ratio;    // Bounds of Rd
+    double diastolic_upper_ratio;
+    double min_omwe_thresh;          // OMWE graph points and MAP are only taken above this normalized pressure
+    double max_omwe_thresh;          // OMWE graph points are only taken below this normalized pressure
+    double map_search_max;           // MAP is only taken below this normalized pressure
+    double map_error_thresh;         // Largest accepted distance between a graph point and the characteristic amplitude
+    double systolic_search_min;      // Pressures accepted as systolic pressure
+    double systolic_search_max;
+    double diastolic_search_min;     // Pressures accepted as diastolic pressure
+    double diastolic_search_max;
+    double envelope_bin_width;       // Width of the pressure bins of the crossing search, 0 selects the nearest point search
+};
+
+MAA_PARAMETERS maa_default_parameters();
+
+// False if the sample type T can not represent the parameters: a bin width below its resolution at the graph pressures
+template <typename T>
+bool maa_parameters_valid(const MAA_PARAMETERS &parameters);
+
+// Final stage of the MAA algorithm: systolic and diastolic pressure from an OMWE graph whose MAP is map with the amplitude peak_amplitude.
+// Only depends on its arguments, so it can be re-run on an extracted graph with other parameters.
+template <typename T>
+BP_PARAMETER maa_bp_calculator(const T *pressures, const T *amplitudes, long points, T peak_amplitude, T map, const MAA_PARAMETERS &parameters);
+
+// Pulse from the times (ms) of the detected heart beats, counting only the intervals between beats whose oscillation maxima (amplitudes)
+// reach min_amplitude
+template <typename T>
+PULSE_READING maa_pulse_calculator(const unsigned long *peak_times_ms, const T *amplitudes, long points, T min_amplitude);
+
+template <typename T>
+class MeasurementSession {
+public:
+    MeasurementSession() : caliberated_MIN_OUT(0), omwebuffer_pointer(0) {
+        set_parameters(maa_default_parameters());
+        reset();
+    }
+
+    void reset();                            // Clears the state of a previous measurement, the calibration is kept
+    void set_calibration(long zero_output);  // Sets the sensor output that corresponds to 0 mmHg (see auto_caliberate())
+    bool set_parameters(const MAA_PARAMETERS &parameters);   // Replaces the MAA parameters, kept by reset() like the calibration; false
+                                                             // and nothing is replaced if they are not valid (maa_parameters_valid())
+    void start_recording();                  // Starts recording the OMWE graph (USER button)
+    T process_pressure_sample(const PRESSURE_SAMPLE &sample);   // Converts, filters and analyses a raw pressure sample
+    long process_pressure_block(const PRESSURE_SAMPLE *samples, long count, T *normalized_pressures = 0);   // Same for a block of samples
+    void check_pressure_gradient();          // Evaluates the pressure release rate, to be called once per second
+    void MAP_calculator();                   // Checks whether the latest OMWE peak is the largest one so far
+    BP_PARAMETER Systolic_and_diastolic_bp_calculator() const;   // Systolic and diastolic blood pressure from the OMWE graph
+    PULSE_READING measure_pulse() const;     // Pulse from the OMWE time buffer
+    void load_omwe_graph(const T *pressures, const T *amplitudes, long points);   // Replaces the OMWE graph and its MAP, e.g. for benchmarks
+
+    T pressure() const { return current_pressure; }
+    T normalized_pressure() const { return pressure_filter.value(); }
+    T release_rate() const { return pressure_release_rate; }
+    T mean_arterial_pressure() const { return Mean_Arterial_Pressure; }
+    T peak_amplitude() const { return peak_pressure_diff; }           // OMWE graph y value at MAP
+    T pressure_difference() const { return pressure_diff; }           // Latest oscillation amplitude seen by MAP_calculator()
+    const MAA_PARAMETERS &parameters() const { return maa_parameters; }
+    long omwe_points() const { return omwebuffer_pointer; }
+    T omwe_pressure(long point) const { return omwegraph_absicissa_buffer[point]; }    // OMWE graph x value (mmHg)
+    T omwe_amplitude(long point) const { return omwegraph_ordinate_buffer[point]; }    // OMWE graph y value (mmHg)
+    long omwe_time_points() const { return omwetime_buffer_pointer; }
+    unsigned long omwe_time(long point) const { return omwe_buffer_time[point]; }      // OMWE time buffer (ms)
+    T omwe_beat_amplitude(long point) const { return omwe_beat_buffer[point]; }       // Oscillation maximum of the beat at omwe_time()
+    bool recording() const { return active_recordflag; }
+    bool max_pressure_reached() const { return max_pressure_flag; }    // The cuff pressure passed 200 mmHg, the pressure can be released
+    bool high_release_rate() const { return high_release_flag; }       // The last gradient check found more than 4 mmHg per second
+    bool complete() const { return end_record; }                      // The pressure dropped below 5 mmHg after recording
+
+private:
+    MAA_PARAMETERS maa_parameters;
+    T min_omwe_thresh;                       // Thresholds of maa_parameters converted once to the sample type
+    T max_omwe_thresh;
+    T map_search_max;
+    T current_pressure;
+    T pressure_release_rate;
+#if PRESSURE_FILTER == PRESSURE_FILTER_MEAN
+    MeanOscillometricFilter<T, NORMALIZE_WINDOW> pressure_filter;   // Normalized (cuff) pressure and oscillation of every reading
+#else
+    OscillometricFilter<T> pressure_filter;
+#endif
+    T omwegraph_absicissa_buffer[OMWE_BUFFER_SIZE];    // Oscillometeric Waveform Envelope (OMWE) graph x values.
+    T omwegraph_ordinate_buffer[OMWE_BUFFER_SIZE];     // Oscillometric Waveform Envelope (OMWE) graph y values
+    unsigned long omwe_buffer_time[BEAT_BUFFER_SIZE];  // Time (ms) relative to the start of the measurement of every detected heart beat
+    T omwe_beat_buffer[BEAT_BUFFER_SIZE];              // Oscillation maximum of every detected heart beat
+    T omwe_candidate_pressure;               // Largest peak of the current OMWE_DECIMATION readings, not yet in the OMWE graph
+    T omwe_candidate_amplitude;
+    bool omwe_candidate;
+    int omwe_decimation_count;               // Readings recorded since the last candidate was stored
+    T beat_amplitude;                        // Largest oscillation of the current positive half wave and its time
+    unsigned long beat_time;
+    bool beat_lobe;                          // The oscillation is above 0, beat_amplitude is being tracked
+    T pressure_diff;
+    T previous_pressure_diff;
+    T peak_pressure_diff;
+    T Mean_Arterial_Pressure;                // Mean Arterial Pressure (MAP) value to be estimated for BP evaluation
+    long caliberated_MIN_OUT;
+    long omwebuffer_pointer;                 // A pointer for storing the latest data location of x and y buffers of OMWE plot
+    long omwetime_buffer_pointer;            // A pointer for storing the latest data location of the OMWE time buffer
+    bool active_recordflag;                  // Flag to indicate if data measured is being recorded for OMWE plot.
+    bool max_pressure_flag;
+    bool high_release_flag;
+    bool end_record;
+
+    int32_t block_counts[PROCESS_BLOCK_SIZE];   // Stages of process_pressure_block(): calibrated counts, converted readings, cuff pressure,
+    T block_readings[PROCESS_BLOCK_SIZE];       // oscillation and the filter value() after every reading
+    T block_pressures[PROCESS_BLOCK_SIZE];
+    T block_oscillations[PROCESS_BLOCK_SIZE];
+    T block_levels[PROCESS_BLOCK_SIZE];
+
+    void analyze_reading(unsigned long Time_ms, T normalized_pressure, T oscillation, T level);
+    void store_omwe_candidate();
+    void store_beat();
+    void update_map(T normalized_pressure);
+};
+
+#endif
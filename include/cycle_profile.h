@@ -0,0 +1,76 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       cycle_profile.h
+* Description: Lightweight instrumentation of the real-time stages. With CYCLE_PROFILING the code between PROFILE_BEGIN(stage) and
+* PROFILE_END(stage) is timed with hal_bench_ticks() (the DWT cycle counter on the target, a few cycles per reading) and its count, minimum,
+* maximum, mean and a log2 histogram are collected per stage; cycle_profile_print() dumps them at the end of the session. Without
+* CYCLE_PROFILING the macros compile to nothing. Every stage must only be timed from one context (thread or ISR), which is the only writer
+* of its statistics, and the statistics must only be read once that context stopped. An ISR is timed into a CYCLE_STATS of its own with
+* PROFILE_END_INTO(), which the thread reading cycle_profile clears and copies into the table of the stage with interrupts masked.
+*/
+
+#ifndef CYCLE_PROFILE_H
+#define CYCLE_PROFILE_H
+
+#include <stdint.h>
+#include "bp_hal.h"
+
+#ifndef CYCLE_PROFILING
+#define CYCLE_PROFILING 0
+#endif
+#define CYCLE_HISTOGRAM_BINS 24         // Bin k counts durations below 2^k ticks (and at least 2^(k-1)), the last bin everything longer
+
+// Instrumented stages
+enum PROFILE_STAGE {
+    PROFILE_SPI_EXCHANGE,           // One framed SPI exchange with the MPR sensor, including the wait for the DMA (acquisition thread)
+    PROFILE_FILTER_UPDATE,          // Cuff pressure and oscillation filter, oscillometric_filter.h (processing loop)
+    PROFILE_OMWE_PEAK_CHECK,        // Peak detection of the OMWE graph (processing loop)
+    PROFILE_MAP_UPDATE,             // MAP_calculator() (processing loop)
+    PROFILE_GRADIENT_ISR,           // Pressure gradient Ticker ISR (interrupt, timed into its own CYCLE_STATS)
+    PROFILE_GRADIENT_CHECK,         // Deferred pressure gradient check (processing loop)
+    PROFILE_STAGE_COUNT
+};
+
+// Duration statistics of one stage, in the unit of hal_bench_unit()
+struct CYCLE_STATS {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t histogram[CYCLE_HISTOGRAM_BINS];
+};
+
+extern CYCLE_STATS cycle_profile[PROFILE_STAGE_COUNT];
+
+inline void cycle_stats_record(CYCLE_STATS &stats, uint32_t ticks) {
+    int bin = ticks ? 32 - __builtin_clz(ticks) : 0;
+    if (bin >= CYCLE_HISTOGRAM_BINS){
+        bin = CYCLE_HISTOGRAM_BINS - 1;
+    }
+    stats.histogram[bin]++;
+    if (stats.count == 0 || ticks < stats.min){
+        stats.min = ticks;
+    }
+    if (ticks > stats.max){
+        stats.max = ticks;
+    }
+    stats.total += ticks;
+    stats.count++;
+}
+
+#if CYCLE_PROFILING
+#define PROFILE_BEGIN(stage) uint32_t profile_start_##stage = hal_bench_ticks()
+#define PROFILE_END(stage) cycle_stats_record(cycle_profile[stage], hal_bench_ticks() - profile_start_##stage)
+#define PROFILE_END_INTO(stage, stats) cycle_stats_record(stats, hal_bench_ticks() - profile_start_##stage)
+#else
+#define PROFILE_BEGIN(stage) ((void)0)
+#define PROFILE_END(stage) ((void)0)
+#define PROFILE_END_INTO(stage, stats) ((void)0)
+#endif
+
+typedef void (*PROFILE_PRINTF)(const char *format, ...);
+
+void cycle_profile_reset();                  // Clears the statistics of all stages
+void cycle_profile_print(PROFILE_PRINTF print);   // One summary and one histogram line per stage that was timed
+
+#endif
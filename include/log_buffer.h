@@ -0,0 +1,67 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       log_buffer.h
+* Description: RAM ring buffer for deferred console output. The producer appends complete, already formatted messages without ever waiting
+* for the UART, and a low priority consumer drains the bytes to the console at whatever rate the serial line allows. A message that does not
+* fit into the free space is dropped as a whole (never truncated) and counted, so the output stays readable when the line is saturated.
+* Like SpscRing it is lock-free for exactly one producer and one consumer context. The capacity has to be a power of two.
+*/
+
+#ifndef LOG_BUFFER_H
+#define LOG_BUFFER_H
+
+#include <atomic>
+#include <stdint.h>
+
+template <uint32_t Capacity>
+class LogBuffer {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "LogBuffer capacity must be a power of two");
+
+public:
+    LogBuffer() : head(0), tail(0), drop_count(0) {}
+
+    // Producer side: append length bytes, returns false (and counts a dropped message) if they do not fit
+    bool write(const char *data, uint32_t length) {
+        uint32_t current_head = head.load(std::memory_order_relaxed);
+        if (Capacity - (current_head - tail.load(std::memory_order_acquire)) < length){
+            drop_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        for (uint32_t i = 0; i < length; i++){
+            buffer[(current_head + i) & (Capacity - 1)] = data[i];
+        }
+        head.store(current_head + length, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: copy up to max_length of the oldest bytes into destination, returns the number of bytes copied
+    uint32_t read(char *destination, uint32_t max_length) {
+        uint32_t current_tail = tail.load(std::memory_order_relaxed);
+        uint32_t available = head.load(std::memory_order_acquire) - current_tail;
+        if (available > max_length){
+            available = max_length;
+        }
+        for (uint32_t i = 0; i < available; i++){
+            destination[i] = buffer[(current_tail + i) & (Capacity - 1)];
+        }
+        tail.store(current_tail + available, std::memory_order_release);
+        return available;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    // Number of messages dropped by write() because the buffer was full
+    uint32_t dropped() const {
+        return drop_count.load(std::memory_order_relaxed);
+    }
+
+private:
+    char buffer[Capacity];
+    std::atomic<uint32_t> head;           // Free running index of the next byte to write, only modified by the producer
+    std::atomic<uint32_t> tail;           // Free running index of the next byte to read, only modified by the consumer
+    std::atomic<uint32_t> drop_count;
+};
+
+#endif
@@ -0,0 +1,79 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       moving_average.h
+* Description: Incremental moving average over the last Window samples. push() updates a running sum in constant time (subtract the sample
+* that leaves the window, add the new one) and caches the mean, so value() never rescans the window and the per-sample cost does not
+* depend on the window length. Until the window is full the mean is taken over the samples received so far.
+* With floating point samples the add/subtract pairs would slowly accumulate rounding error over a long session, so a second sum of only
+* the samples written during the current lap of the window is kept, and it replaces the running sum every time the write index wraps.
+* This bounds the error to one window worth of additions, still at constant cost per sample. Fixed-point sums are exact anyway.
+*/
+
+#ifndef MOVING_AVERAGE_H
+#define MOVING_AVERAGE_H
+
+template <typename T, int Window>
+class MovingAverage {
+    static_assert(Window > 0, "MovingAverage window must hold at least one sample");
+
+public:
+    MovingAverage() {
+        reset();
+    }
+
+    void reset() {
+        for (int i = 0; i < Window; i++){
+            window[i] = T(0);
+        }
+        running_sum = T(0);
+        lap_sum = T(0);
+        mean = T(0);
+        index = 0;
+        sample_count = 0;
+    }
+
+    void push(T sample) {
+        if (sample_count == Window){
+            running_sum -= window[index];     // The oldest sample leaves the window
+        }
+        else {
+            sample_count++;
+        }
+        window[index] = sample;
+        running_sum += sample;
+        lap_sum += sample;
+        if (++index == Window){
+            index = 0;
+            running_sum = lap_sum;            // Exactly the samples currently in the window, drops any drift of the running sum
+            lap_sum = T(0);
+        }
+        mean = running_sum / sample_count;
+    }
+
+    // Mean of the samples in the window (0 before the first push)
+    T value() const {
+        return mean;
+    }
+
+    int count() const {
+        return sample_count;
+    }
+
+    bool full() const {
+        return sample_count == Window;
+    }
+
+    static int window_length() {
+        return Window;
+    }
+
+private:
+    T window[Window];
+    T running_sum;
+    T lap_sum;          // Sum of the samples written since the write index last wrapped
+    T mean;
+    int index;          // Slot of the next (and the oldest) sample
+    int sample_count;
+};
+
+#endif
@@ -0,0 +1,30 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       mpr_acquisition.h
+* Description: Reading raw samples from the MPR sensor through the hardware abstraction of bp_hal.h. The end of a conversion is detected
+* as selected by MPR_ACQUISITION_MODE, and with MPR_PIPELINED the next conversion runs while the previous sample is being processed.
+* All functions must be called from a single acquisition context: the acquisition thread of main.cpp on the target, which also runs the
+* calibration and installs the recorder at the start of every measurement, and the simulation loop of the host build.
+*/
+
+#ifndef MPR_ACQUISITION_H
+#define MPR_ACQUISITION_H
+
+#include "bp_monitor.h"
+
+// Receives every sample returned by measure_pressure() and measure_pressure_pipelined(), in the acquisition context, except the ones
+// flagged MPR_STATUS_TRANSFER_FAILED
+typedef void (*SAMPLE_RECORDER)(const PRESSURE_SAMPLE &sample);
+
+PRESSURE_SAMPLE measure_pressure();  // Function routine to read one raw pressure sample from the MPR sensor
+PRESSURE_SAMPLE measure_pressure_pipelined();   // Reads the pending conversion and immediately starts the next one
+bool start_conversion();             // Sends the output measurement command to the MPR sensor, false if the SPI exchange failed
+void wait_for_conversion();          // Blocks until the running conversion is finished, as selected by MPR_ACQUISITION_MODE
+PRESSURE_SAMPLE read_conversion(unsigned long started_us);   // Reads the status byte and the 24 bit output of the finished conversion
+                                     // Samples whose SPI exchanges failed have MPR_STATUS_TRANSFER_FAILED set in their status
+void reset_acquisition();            // Forgets a pending pipelined conversion, before a new measurement starts
+void set_sample_recorder(SAMPLE_RECORDER recorder);   // Installs a recorder of the raw samples (0 to remove it), see session_record.h
+long auto_caliberate();              // Averages the sensor output at 0 mmHg, the result is the zero reference for set_calibration()
+                                     // Failed readings are skipped
+
+#endif
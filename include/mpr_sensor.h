@@ -0,0 +1,75 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       mpr_sensor.h
+* Description: SPI protocol constants of the Honeywell MPR series pressure sensor. A conversion is started with the 3 byte command
+* 0xAA -> 0x00 -> 0x00 and the result is read with 0xF0 followed by 3 dummy bytes, which returns the status byte and the 24 bit output.
+* Sending 0xF0 alone only clocks out the status byte, which is used to poll the busy flag while a conversion is running.
+* MprSensor describes one sensor of the series as a type: the transfer function and the pressure range of the part number, from which the
+* output range and the pressure per count are compile time constants.
+*/
+
+#ifndef MPR_SENSOR_H
+#define MPR_SENSOR_H
+
+#define MPR_CMD_START_CONVERSION 0xAA    // Output measurement command
+#define MPR_CMD_READ 0xF0                // Read status byte (and data) command / NOP
+
+#define MPR_STATUS_POWERED 0x40          // Device is powered, always set in a valid reading
+#define MPR_STATUS_BUSY 0x20             // Conversion in progress, the data bytes are not valid yet
+#define MPR_STATUS_INTEGRITY_ERROR 0x04  // Checksum of the internal memory failed
+#define MPR_STATUS_SATURATION 0x01       // Internal math saturation, the output is clipped
+#define MPR_STATUS_TRANSFER_FAILED 0x80  // Never sent by the sensor: an SPI exchange of the reading failed, set by the acquisition code
+
+#define MPR_STATUS_ERROR_MASK (MPR_STATUS_BUSY | MPR_STATUS_INTEGRITY_ERROR | MPR_STATUS_SATURATION | MPR_STATUS_TRANSFER_FAILED)
+
+// Acquisition modes deciding how measure_pressure() waits for the end of a conversion
+#define MPR_WAIT_FIXED 0                 // Fixed 10 ms delay, works with any wiring
+#define MPR_WAIT_EOC 1                   // Interrupt on the rising edge of the sensor's EOC pin
+#define MPR_WAIT_BUSY_POLL 2             // Poll the busy flag of the status byte with a short backoff
+
+#define MPR_CONVERSION_TIMEOUT_US 10000  // Worst case conversion time, also the timeout of the EOC and polling modes
+
+// Transfer functions: output at the minimum and maximum of the pressure range, in percent of 2^24 counts
+#define MPR_TRANSFER_A 0                 // 10% - 90%
+#define MPR_TRANSFER_B 1                 // 2.5% - 22.5%
+#define MPR_TRANSFER_C 2                 // 20% - 80%
+
+// Units of the pressure range in the part number
+#define MPR_UNIT_MMHG 0
+#define MPR_UNIT_PSI 1
+#define MPR_UNIT_KPA 2
+#define MPR_UNIT_MBAR 3
+#define MPR_UNIT_BAR 4
+
+constexpr double mpr_unit_mmhg(int unit) {
+    return unit == MPR_UNIT_PSI ? 51.71493 : unit == MPR_UNIT_KPA ? 7.500617 : unit == MPR_UNIT_MBAR ? 0.7500617 :
+           unit == MPR_UNIT_BAR ? 750.0617 : 1.0;
+}
+
+// Sensor with transfer function TransferFunction and the pressure range RangeMin - RangeMax in Unit (e.g. MPRLS0300YG: B, 0 - 300 mmHg).
+// Pressures are in mmHg whatever the unit of the range.
+template <int TransferFunction, int RangeMin, int RangeMax, int Unit>
+struct MprSensor {
+    static_assert(TransferFunction >= MPR_TRANSFER_A && TransferFunction <= MPR_TRANSFER_C, "Unknown MPR transfer function");
+    static_assert(Unit >= MPR_UNIT_MMHG && Unit <= MPR_UNIT_BAR, "Unknown MPR pressure unit");
+    static_assert(RangeMin < RangeMax, "Empty MPR pressure range");
+
+    // Output counts of the datasheet
+    static constexpr long output_min() {
+        return TransferFunction == MPR_TRANSFER_A ? 1677722L : TransferFunction == MPR_TRANSFER_B ? 419430L : 3355443L;
+    }
+    static constexpr long output_max() {
+        return TransferFunction == MPR_TRANSFER_A ? 15099494L : TransferFunction == MPR_TRANSFER_B ? 3774873L : 13421773L;
+    }
+    static constexpr double pressure_min() {
+        return RangeMin * mpr_unit_mmhg(Unit);
+    }
+    static constexpr double pressure_max() {
+        return RangeMax * mpr_unit_mmhg(Unit);
+    }
+    static constexpr double pressure_per_count() {
+        return (pressure_max() - pressure_min()) / (double)(output_max() - output_min());
+    }
+};
+
+#endif
@@ -0,0 +1,130 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       oscillometric_filter.h
+* Description: Splits the calibrated pressure readings into the two signals of the oscillometric method: the cuff pressure track (the
+* deflation ramp, x axis of the OMWE graph) and the oscillation track (the pulse in the cuff, whose peaks make up the y axis). Selected at
+* build time with PRESSURE_FILTER:
+*
+*   -DPRESSURE_FILTER=PRESSURE_FILTER_BIQUAD   4th order Butterworth low-pass at CUFF_LOWPASS_HZ for the cuff pressure, band-pass
+*                                              OSCILLATION_LOW_HZ - OSCILLATION_HIGH_HZ (2nd order high-pass and low-pass) for the
+*                                              oscillations, biquad_filter.h (default)
+*   -DPRESSURE_FILTER=PRESSURE_FILTER_MEAN     running mean of the previous NORMALIZE_WINDOW readings as cuff pressure, the reading minus
+*                                              that mean as oscillation (the original normalization)
+*
+* The mean passes everything above a few Hz into the oscillation track, the sensor noise included, and its cuff pressure still carries
+* the pulse. The filters are designed for SAMPLE_RATE_HZ (the host tools refuse sessions recorded at another rate) and start from the first
+* reading as if it had been constant before, so there is no settling transient. Both classes process a block of readings in one call and have the same interface, value() is the cuff pressure
+* after the latest reading. The running mean gives a reading the mean of the readings before it, so its value() after a reading differs from
+* the cuff pressure of that reading; process() also returns value() after every reading for the stages that use it.
+*/
+
+#ifndef OSCILLOMETRIC_FILTER_H
+#define OSCILLOMETRIC_FILTER_H
+
+#include "biquad_filter.h"
+#include "bp_config.h"
+#include "moving_average.h"
+
+#define PRESSURE_FILTER_MEAN   0
+#define PRESSURE_FILTER_BIQUAD 1
+
+#ifndef PRESSURE_FILTER
+#define PRESSURE_FILTER PRESSURE_FILTER_BIQUAD
+#endif
+
+#if PRESSURE_FILTER == PRESSURE_FILTER_MEAN
+// The running sum of the mean holds NORMALIZE_WINDOW readings in the 32 bit word of count_t, which every build instantiates. A full scale
+// reading is (output_max - output_min) << frac_bits: 40 readings of transfer function B, 10 of A.
+static_assert((double)NORMALIZE_WINDOW * (CuffSensor::output_max() - CuffSensor::output_min()) * (1 << count_t::frac_bits) <= INT32_MAX,
+              "NORMALIZE_WINDOW full scale readings overflow the running sum of count_t");
+#endif
+
+template <typename T>
+class OscillometricFilter {
+public:
+    OscillometricFilter() {
+        // Pole pairs of the 4th order Butterworth low-pass: q = 1 / (2 cos(pi/8)) and 1 / (2 cos(3 pi/8))
+        const BIQUAD_SECTION cuff_sections[2] = {biquad_lowpass(CUFF_LOWPASS_HZ, 0.5412, SAMPLE_RATE_HZ),
+                                                 biquad_lowpass(CUFF_LOWPASS_HZ, 1.3066, SAMPLE_RATE_HZ)};
+        const BIQUAD_SECTION oscillation_sections[2] = {biquad_highpass(OSCILLATION_LOW_HZ, 0.7071, SAMPLE_RATE_HZ),
+                                                        biquad_lowpass(OSCILLATION_HIGH_HZ, 0.7071, SAMPLE_RATE_HZ)};
+        cuff_filter.configure(cuff_sections);
+        oscillation_filter.configure(oscillation_sections);
+        reset();
+    }
+
+    void reset() {
+        cuff_pressure = T(0);
+        started = false;
+    }
+
+    // Cuff pressure and oscillation of count readings, and value() after each of them if values is not 0. The output buffers must not
+    // overlap readings.
+    void process(const T *readings, T *pressures, T *oscillations, T *values, int count) {
+        if (count <= 0){
+            return;
+        }
+        if (!started){
+            cuff_filter.reset(readings[0]);
+            oscillation_filter.reset(readings[0]);
+            started = true;
+        }
+        cuff_filter.process(readings, pressures, count);
+        oscillation_filter.process(readings, oscillations, count);
+        cuff_pressure = pressures[count - 1];
+        if (values){
+            for (int i = 0; i < count; i++){
+                values[i] = pressures[i];
+            }
+        }
+    }
+
+    T value() const {
+        return cuff_pressure;
+    }
+
+    bool full() const {
+        return started;
+    }
+
+private:
+    BiquadCascade<T, 2> cuff_filter;
+    BiquadCascade<T, 2> oscillation_filter;
+    T cuff_pressure;
+    bool started;
+};
+
+// The original normalization: the cuff pressure of a reading is the mean of the Window readings before it
+template <typename T, int Window>
+class MeanOscillometricFilter {
+public:
+    void reset() {
+        mean.reset();
+    }
+
+    void process(const T *readings, T *pressures, T *oscillations, T *values, int count) {
+        for (int i = 0; i < count; i++){
+            T pressure = mean.value();
+            T oscillation = readings[i] - pressure;
+            mean.push(readings[i]);
+            pressures[i] = pressure;
+            oscillations[i] = oscillation;
+            if (values){
+                values[i] = mean.value();
+            }
+        }
+    }
+
+    T value() const {
+        return mean.value();
+    }
+
+    bool full() const {
+        return mean.full();
+    }
+
+private:
+    MovingAverage<T, Window> mean;
+};
+
+#endif
@@ -0,0 +1,141 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       pressure_conversion.h
+* Description: Conversion of calibrated sensor counts (24 bit output minus the output at 0 mmHg) into pressure in mmHg. The sensor is a
+* template parameter (MprSensor of mpr_sensor.h, CuffSensor of the build by default), so the pressure per count of its transfer function
+* and range is a compile time constant and a conversion is one multiplication in the sample type. convert() takes a block of counts and is
+* the kernel of process_pressure_block():
+*
+*   float    host: 4 (SSE2) or 8 (AVX) counts per instruction. Cortex-M4F: one VCVT and one VMUL per count, the FPU has no SIMD and the DSP
+*            SIMD instructions only take 8 or 16 bit lanes, too narrow for the counts.
+*   double   host: 2 (SSE2) or 4 (AVX) counts per instruction, software emulated on the Cortex-M4F
+*   Q16.16   one 32 x 32 -> 64 bit multiplication keeping the high word (a single SMULL on the Cortex-M4)
+*   counts   no conversion at all, the calibrated counts are only shifted into count_t
+*
+* The block kernels give the same result as converting the counts one at a time, on every build.
+*/
+
+#ifndef PRESSURE_CONVERSION_H
+#define PRESSURE_CONVERSION_H
+
+#include <stdint.h>
+#include "bp_config.h"
+#include "sample_types.h"
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+template <typename T, typename Sensor = CuffSensor>
+struct PressureConversion {
+    static T convert(int32_t counts) {
+        return (T)counts * (T)Sensor::pressure_per_count();
+    }
+
+    static void convert(const int32_t *counts, T *pressures, int count) {
+        for (int i = 0; i < count; i++){
+            pressures[i] = convert(counts[i]);
+        }
+    }
+};
+
+template <typename Sensor>
+struct PressureConversion<float, Sensor> {
+    static float convert(int32_t counts) {
+        return (float)counts * (float)Sensor::pressure_per_count();
+    }
+
+    static void convert(const int32_t *counts, float *pressures, int count) {
+        int i = 0;
+#if defined(__AVX__)
+        const __m256 scale = _mm256_set1_ps((float)Sensor::pressure_per_count());
+        for (; i + 8 <= count; i += 8){
+            __m256i lanes = _mm256_loadu_si256((const __m256i *)(counts + i));
+            _mm256_storeu_ps(pressures + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lanes), scale));
+        }
+#elif defined(__SSE2__)
+        const __m128 scale = _mm_set1_ps((float)Sensor::pressure_per_count());
+        for (; i + 4 <= count; i += 4){
+            __m128i lanes = _mm_loadu_si128((const __m128i *)(counts + i));
+            _mm_storeu_ps(pressures + i, _mm_mul_ps(_mm_cvtepi32_ps(lanes), scale));
+        }
+#endif
+        for (; i < count; i++){
+            pressures[i] = convert(counts[i]);
+        }
+    }
+};
+
+template <typename Sensor>
+struct PressureConversion<double, Sensor> {
+    static double convert(int32_t counts) {
+        return (double)counts * Sensor::pressure_per_count();
+    }
+
+    static void convert(const int32_t *counts, double *pressures, int count) {
+        int i = 0;
+#if defined(__AVX__)
+        const __m256d scale = _mm256_set1_pd(Sensor::pressure_per_count());
+        for (; i + 4 <= count; i += 4){
+            __m128i lanes = _mm_loadu_si128((const __m128i *)(counts + i));
+            _mm256_storeu_pd(pressures + i, _mm256_mul_pd(_mm256_cvtepi32_pd(lanes), scale));
+        }
+#elif defined(__SSE2__)
+        const __m128d scale = _mm_set1_pd(Sensor::pressure_per_count());
+        for (; i + 2 <= count; i += 2){
+            __m128i lanes = _mm_loadl_epi64((const __m128i *)(counts + i));
+            _mm_storeu_pd(pressures + i, _mm_mul_pd(_mm_cvtepi32_pd(lanes), scale));
+        }
+#endif
+        for (; i < count; i++){
+            pressures[i] = convert(counts[i]);
+        }
+    }
+};
+
+// Smallest left shift of the counts for which the pressure per count in Q0.(48 - shift) fits in 31 bits
+constexpr int pressure_count_shift(double pressure_per_count) {
+    int shift = 0;
+    while (shift < 7 && pressure_per_count * (double)((int64_t)1 << (48 - shift)) >= 2147483648.0){
+        shift++;
+    }
+    return shift;
+}
+
+// Counts are shifted left by up to 6 bits (|counts| < 2^25 with a 24 bit sensor) and multiplied by the pressure per count in
+// Q0.(48 - shift): 4 bits and Q0.44 for the 300 mmHg sensor with transfer function B, where the scale rounding error is below 2^-7 LSB
+// over the full 24 bit range. Sensors above 4.9e-4 mmHg per count (about 1600 mmHg with transfer function B) do not fit.
+template <typename Sensor>
+struct PressureConversion<q16_16_t, Sensor> {
+    static constexpr int shift = pressure_count_shift(Sensor::pressure_per_count());
+    static_assert(shift <= 6, "Pressure per count too large for the Q16.16 conversion");
+    static constexpr int32_t scale = (int32_t)(Sensor::pressure_per_count() * (double)((int64_t)1 << (48 - shift)) + 0.5);
+
+    static q16_16_t convert(int32_t counts) {
+        return q16_16_t::from_raw((int32_t)(((int64_t)(counts * (1 << shift)) * scale) >> 32));
+    }
+
+    static void convert(const int32_t *counts, q16_16_t *pressures, int count) {
+        for (int i = 0; i < count; i++){
+            pressures[i] = convert(counts[i]);
+        }
+    }
+};
+
+// Readings of the sensor the counts are kept in
+template <typename Sensor, int FracBits>
+struct PressureConversion<SensorCounts<Sensor, FracBits>, Sensor> {
+    typedef SensorCounts<Sensor, FracBits> Counts;
+
+    static Counts convert(int32_t counts) {
+        return Counts::from_raw(counts * (1 << FracBits));
+    }
+
+    static void convert(const int32_t *counts, Counts *pressures, int count) {
+        for (int i = 0; i < count; i++){
+            pressures[i] = convert(counts[i]);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,69 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       session_record.h
+* Description: Compact image of the raw sensor readings of one measurement, written by the target with SESSION_RECORDING and replayed
+* by the host build (program replay session.bps). The image is an 8 byte header followed by 8 byte entries:
+*
+*   header  "BPS1", u16 format version (1), u16 sample rate (Hz)
+*   entry   u32 timestamp (us), u8 status byte, u24 raw sensor output           (all little endian)
+*
+* The MPR sensor never sets bit 7 of its status byte, so an entry with SESSION_EVENT set in the status byte is an event instead of a
+* reading and carries the event code in the data field. The first readings of an image are the ones averaged by auto_caliberate().
+*/
+
+#ifndef SESSION_RECORD_H
+#define SESSION_RECORD_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define SESSION_MAGIC "BPS1"
+#define SESSION_VERSION 1
+#define SESSION_HEADER_SIZE 8
+#define SESSION_ENTRY_SIZE 8
+#define SESSION_EVENT 0x80               // Status bit marking an event entry
+#define SESSION_EVENT_RECORD_START 1     // The USER button started the OMWE recording, at the timestamp of the sample processed next
+
+// One entry of a session image
+struct SESSION_ENTRY {
+    unsigned long timestamp_us;
+    long pressure_data;              // 24 bit sensor output, or the event code of an event entry
+    unsigned char status;
+};
+
+inline void session_put_header(uint8_t *image, uint16_t sample_rate_hz) {
+    memcpy(image, SESSION_MAGIC, 4);
+    image[4] = (uint8_t)SESSION_VERSION;
+    image[5] = (uint8_t)(SESSION_VERSION >> 8);
+    image[6] = (uint8_t)sample_rate_hz;
+    image[7] = (uint8_t)(sample_rate_hz >> 8);
+}
+
+// Returns false if the header is not a supported session image
+inline bool session_get_header(const uint8_t *image, uint16_t &sample_rate_hz) {
+    if (memcmp(image, SESSION_MAGIC, 4) != 0 || (image[4] | image[5] << 8) != SESSION_VERSION){
+        return false;
+    }
+    sample_rate_hz = (uint16_t)(image[6] | image[7] << 8);
+    return true;
+}
+
+inline void session_put_entry(uint8_t *destination, const SESSION_ENTRY &entry) {
+    for (int i = 0; i < 4; i++){
+        destination[i] = (uint8_t)(entry.timestamp_us >> (8 * i));
+    }
+    destination[4] = entry.status;
+    for (int i = 0; i < 3; i++){
+        destination[5 + i] = (uint8_t)(entry.pressure_data >> (8 * i));
+    }
+}
+
+inline SESSION_ENTRY session_get_entry(const uint8_t *source) {
+    SESSION_ENTRY entry;
+    entry.timestamp_us = (unsigned long)source[0] | (unsigned long)source[1] << 8 | (unsigned long)source[2] << 16 | (unsigned long)source[3] << 24;
+    entry.status = source[4];
+    entry.pressure_data = (long)source[5] | (long)source[6] << 8 | (long)source[7] << 16;
+    return entry;
+}
+
+#endif
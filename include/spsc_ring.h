@@ -0,0 +1,85 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       spsc_ring.h
+* Description: Fixed capacity, wait-free single-producer/single-consumer ring buffer. It is used to carry the raw MPR samples from the
+* acquisition context to the processing pipeline without locks, heap allocation or torn reads. The capacity has to be a power of two so that
+* the free running head and tail indices can be mapped onto the storage with a mask instead of a division.
+* Exactly one context may call push() and exactly one (other) context may call pop(). If the ring is full, push() drops the new item and
+* increments the overrun counter instead of overwriting data the consumer has not read yet.
+*/
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <stdint.h>
+
+template <typename T, uint32_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing() : head(0), tail(0), overrun_count(0) {}
+
+    // Producer side: store a copy of the item, returns false (and counts an overrun) if the ring is full
+    bool push(const T &item) {
+        uint32_t current_head = head.load(std::memory_order_relaxed);
+        if (current_head - tail.load(std::memory_order_acquire) == Capacity){
+            overrun_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        buffer[current_head & (Capacity - 1)] = item;
+        head.store(current_head + 1, std::memory_order_release);   // Publish the item only after it has been completely written
+        return true;
+    }
+
+    // Consumer side: move the oldest item into item, returns false if the ring is empty
+    bool pop(T &item) {
+        uint32_t current_tail = tail.load(std::memory_order_relaxed);
+        if (current_tail == head.load(std::memory_order_acquire)){
+            return false;
+        }
+        item = buffer[current_tail & (Capacity - 1)];
+        tail.store(current_tail + 1, std::memory_order_release);   // Hand the slot back to the producer
+        return true;
+    }
+
+    // Consumer side: move up to max_items of the oldest items into items, returns how many were moved. The slots are handed back to the
+    // producer once, after all of them were copied.
+    uint32_t pop(T *items, uint32_t max_items) {
+        uint32_t current_tail = tail.load(std::memory_order_relaxed);
+        uint32_t available = head.load(std::memory_order_acquire) - current_tail;
+        uint32_t count = available < max_items ? available : max_items;
+        for (uint32_t i = 0; i < count; i++){
+            items[i] = buffer[(current_tail + i) & (Capacity - 1)];
+        }
+        tail.store(current_tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Number of items waiting to be consumed (a snapshot, exact only when called from the consumer side)
+    uint32_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    // Number of items dropped by push() because the consumer fell behind
+    uint32_t overruns() const {
+        return overrun_count.load(std::memory_order_relaxed);
+    }
+
+    static uint32_t capacity() {
+        return Capacity;
+    }
+
+private:
+    T buffer[Capacity];
+    std::atomic<uint32_t> head;            // Free running index of the next slot to write, only modified by the producer
+    std::atomic<uint32_t> tail;            // Free running index of the next slot to read, only modified by the consumer
+    std::atomic<uint32_t> overrun_count;
+};
+
+#endif
@@ -0,0 +1,106 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       telemetry.h
+* Description: Binary telemetry records. Every record is laid out as
+*
+*   [record type : 1 byte] [payload : little endian fields] [CRC-16/CCITT-FALSE of type and payload : 2 bytes, little endian]
+*
+* and is COBS encoded and terminated with a 0x00 delimiter, so a receiver can resynchronise on any frame boundary. The payloads are:
+*
+*   TELEMETRY_SAMPLE      u32 timestamp (us), u32 raw 24 bit count, u8 status byte, f32 normalized pressure (mmHg)
+*   TELEMETRY_OMWE_POINT  u32 timestamp (ms), f32 pressure (mmHg), f32 oscillation amplitude (mmHg)
+*   TELEMETRY_BP_RESULT   f32 systolic, f32 diastolic, f32 MAP (mmHg), f32 systolic deviation, f32 diastolic deviation
+*   TELEMETRY_PULSE       f32 pulse (bpm), u32 number of reliable pulse intervals
+*   TELEMETRY_SESSION     u32 byte offset, up to TELEMETRY_SESSION_CHUNK bytes of the session image (SESSION_RECORDING, see session_record.h)
+*   TELEMETRY_TEXT        the characters of a console message (no terminator)
+*
+* tools/telemetry_decode.py decodes a recorded stream or a live serial port.
+*/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TELEMETRY_SAMPLE 0x01
+#define TELEMETRY_OMWE_POINT 0x02
+#define TELEMETRY_BP_RESULT 0x03
+#define TELEMETRY_PULSE 0x04
+#define TELEMETRY_SESSION 0x05
+#define TELEMETRY_TEXT 0x10
+
+#define TELEMETRY_MAX_PAYLOAD 160
+#define TELEMETRY_SESSION_CHUNK 128
+// Type + payload + CRC, plus the COBS overhead (one byte per 254) and the delimiter
+#define TELEMETRY_MAX_FRAME (1 + TELEMETRY_MAX_PAYLOAD + 2 + (1 + TELEMETRY_MAX_PAYLOAD + 2) / 254 + 1 + 1)
+
+inline uint16_t telemetry_crc16(const uint8_t *data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++){
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++){
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Consistent Overhead Byte Stuffing: removes all 0x00 bytes from the data, returns the encoded length (at most length + length / 254 + 1)
+inline size_t cobs_encode(const uint8_t *data, size_t length, uint8_t *encoded) {
+    size_t code_index = 0;
+    size_t out = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < length; i++){
+        if (data[i] == 0){
+            encoded[code_index] = code;
+            code_index = out++;
+            code = 1;
+        }
+        else {
+            encoded[out++] = data[i];
+            if (++code == 0xFF){
+                encoded[code_index] = code;
+                code_index = out++;
+                code = 1;
+            }
+        }
+    }
+    encoded[code_index] = code;
+    return out;
+}
+
+inline void telemetry_put_u8(uint8_t *&cursor, uint8_t value) {
+    *cursor++ = value;
+}
+
+inline void telemetry_put_u32(uint8_t *&cursor, uint32_t value) {
+    for (int i = 0; i < 4; i++){
+        *cursor++ = (uint8_t)(value >> (8 * i));
+    }
+}
+
+inline void telemetry_put_f32(uint8_t *&cursor, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    telemetry_put_u32(cursor, bits);
+}
+
+// Builds the complete frame of a record into frame (TELEMETRY_MAX_FRAME bytes), returns the number of bytes to transmit
+inline size_t telemetry_frame(uint8_t type, const uint8_t *payload, size_t length, uint8_t *frame) {
+    uint8_t record[1 + TELEMETRY_MAX_PAYLOAD + 2];
+    if (length > TELEMETRY_MAX_PAYLOAD){
+        length = TELEMETRY_MAX_PAYLOAD;
+    }
+    record[0] = type;
+    memcpy(record + 1, payload, length);
+    uint16_t crc = telemetry_crc16(record, length + 1);
+    record[length + 1] = (uint8_t)crc;
+    record[length + 2] = (uint8_t)(crc >> 8);
+    size_t encoded_length = cobs_encode(record, length + 3, frame);
+    frame[encoded_length] = 0x00;      // Frame delimiter
+    return encoded_length + 1;
+}
+
+#endif
@@ -0,0 +1,250 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       benchmark.cpp
+* Description: Benchmarks of the measurement pipeline stages, see benchmark.h. Shared by the target (BENCHMARK_MODE) and the host build
+* (program bench).
+*/
+
+#include "benchmark.h"
+#include <math.h>
+#include "bp_hal.h"
+#include "bp_monitor.h"
+#include "moving_average.h"
+#include "oscillometric_filter.h"
+#include "pressure_conversion.h"
+
+long bench_counts[BENCH_SESSION_SAMPLES];      // Raw sensor output of the synthetic deflation
+volatile double bench_sink;                    // Results are written here so the compiler can not drop the timed work
+
+/***Function to build the synthetic deflation*****
+50 Hz samples of a cuff released from 210 mmHg at 3 mmHg per second, with a 72 bpm pulse whose amplitude peaks at 93 mmHg, converted with
+transfer function B. The waveform only has to exercise every branch of the algorithm, see src/host/waveform_generator.h for a realistic one. */
+
+void bench_build_session() {
+    for (int i = 0; i < BENCH_SESSION_SAMPLES; i++){
+        double time_s = i / 50.0;
+        double cuff = 210.0 - 3.0 * time_s;
+        if (cuff < 0.0){
+            cuff = 0.0;
+        }
+        double envelope = 2.0 * exp(-pow((cuff - 93.0) / 30.0, 2));
+        double beat = sin(M_PI * fmod(time_s * 1.2, 1.0));
+        double pressure = cuff + envelope * beat * beat;
+        bench_counts[i] = OUTPUT_MIN + (long)(pressure * (OUTPUT_MAX - OUTPUT_MIN) / (PRESSURE_MAX - PRESSURE_MIN) + 0.5);
+    }
+}
+
+// Times body (which makes calls calls) BENCH_REPEATS times and reports the fastest run
+template <typename F>
+void bench_stage(BENCH_REPORT report, const char *stage, const char *sample_type, unsigned long size, unsigned long calls, F body) {
+    uint32_t best = 0xFFFFFFFF;
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++){
+        uint32_t start = hal_bench_ticks();
+        body();
+        uint32_t elapsed = hal_bench_ticks() - start;
+        if (elapsed < best){
+            best = elapsed;
+        }
+    }
+    BENCH_RESULT result = {stage, sample_type, size, calls, (double)best / calls};
+    report(result);
+}
+
+// One count per call like process_pressure_sample(), and the whole deflation in one call of the block kernel
+template <typename T>
+void bench_convert(BENCH_REPORT report) {
+    static int32_t counts[BENCH_SESSION_SAMPLES];
+    static T pressures[BENCH_SESSION_SAMPLES];
+    for (int i = 0; i < BENCH_SESSION_SAMPLES; i++){
+        counts[i] = (int32_t)(bench_counts[i] - OUTPUT_MIN);
+    }
+    bench_stage(report, "convert", SampleTraits<T>::name(), 1, BENCH_SESSION_SAMPLES, [&]() {
+        T sum(0);
+        for (int i = 0; i < BENCH_SESSION_SAMPLES; i++){
+            sum = sum + PressureConversion<T>::convert(counts[i]);
+        }
+        bench_sink = (double)sum;
+    });
+    bench_stage(report, "convert", SampleTraits<T>::name(), BENCH_SESSION_SAMPLES, BENCH_SESSION_SAMPLES, [&]() {
+        PressureConversion<T>::convert(counts, pressures, BENCH_SESSION_SAMPLES);
+        bench_sink = (double)pressures[BENCH_SESSION_SAMPLES - 1];
+    });
+}
+
+template <typename T, int Window>
+void bench_normalize(BENCH_REPORT report) {
+    static MovingAverage<T, Window> filter;
+    static T pressures[BENCH_SESSION_SAMPLES];
+    for (int i = 0; i < BENCH_SESSION_SAMPLES; i++){
+        pressures[i] = PressureConversion<T>::convert((int32_t)(bench_counts[i] - OUTPUT_MIN));
+    }
+    bench_stage(report, "normalize", SampleTraits<T>::name(), Window, BENCH_SESSION_SAMPLES, [&]() {
+        T sum(0);
+        filter.reset();
+        for (int i = 0; i < BENCH_SESSION_SAMPLES; i++){
+            filter.push(pressures[i]);
+            sum = sum + filter.value();
+        }
+        bench_sink = (double)sum;
+    });
+}
+
+// Cuff pressure and oscillation of the deflation, Block readings per call (1: the processing loop, one reading per call)
+template <typename T, int Block>
+void bench_filter(BENCH_REPORT report) {
+    static OscillometricFilter<T> filter;
+    static T readings[BENCH_SESSION_SAMPLES];
+    static T pressures[BENCH_SESSION_SAMPLES];
+    static T oscillations[BENCH_SESSION_SAMPLES];
+    const int samples = BENCH_SESSION_SAMPLES - BENCH_SESSION_SAMPLES % Block;
+    for (int i = 0; i < samples; i++){
+        readings[i] = PressureConversion<T>::convert((int32_t)(bench_counts[i] - OUTPUT_MIN));
+    }
+    bench_stage(report, "filter", SampleTraits<T>::name(), Block, samples, [&]() {
+        filter.reset();
+        for (int i = 0; i < samples; i += Block){
+            filter.process(readings + i, pressures + i, oscillations + i, 0, Block);
+        }
+        bench_sink = (double)(pressures[samples - 1] + oscillations[samples - 1]);
+    });
+}
+
+// Feeds the synthetic deflation through process_pressure_sample() like the processing loop does, returns the number of samples processed
+template <typename T>
+unsigned long bench_run_session(MeasurementSession<T> &session) {
+    session.reset();
+    session.set_calibration(OUTPUT_MIN);
+    unsigned long processed = 0;
+    for (int i = 0; i < BENCH_SESSION_SAMPLES && !session.complete(); i++){
+        PRESSURE_SAMPLE sample = {(unsigned long)i * 20000UL, 0, bench_counts[i], MPR_STATUS_POWERED};
+        if (i == NORMALIZE_WINDOW){        // USER button, once the normalized pressure is valid
+            session.start_recording();
+        }
+        bench_sink = (double)session.process_pressure_sample(sample);
+        processed++;
+    }
+    return processed;
+}
+
+// Same with process_pressure_block(), which takes the readings in blocks of PROCESS_BLOCK_SIZE
+template <typename T>
+unsigned long bench_run_session_blocks(MeasurementSession<T> &session, const PRESSURE_SAMPLE *samples) {
+    session.reset();
+    session.set_calibration(OUTPUT_MIN);
+    unsigned long processed = session.process_pressure_block(samples, NORMALIZE_WINDOW);
+    session.start_recording();
+    processed += session.process_pressure_block(samples + NORMALIZE_WINDOW, BENCH_SESSION_SAMPLES - NORMALIZE_WINDOW);
+    return processed;
+}
+
+// Loads an OMWE graph of synthetic points, a triangular envelope over a pressure falling from 160 to 40 mmHg
+template <typename T>
+void bench_load_omwe(MeasurementSession<T> &session, long points) {
+    static T pressures[OMWE_BUFFER_SIZE];
+    static T amplitudes[OMWE_BUFFER_SIZE];
+    for (long i = 0; i < points; i++){
+        double pressure = 160.0 - 120.0 * i / points;
+        pressures[i] = T(pressure);
+        amplitudes[i] = T(2.0 - fabs(pressure - 93.0) / 50.0);
+    }
+    session.load_omwe_graph(pressures, amplitudes, points);
+}
+
+// Systolic/diastolic search on the graph of the session: envelope crossings (the session parameters) and the nearest point search
+template <typename T>
+void bench_bp_calculator(BENCH_REPORT report, MeasurementSession<T> &session) {
+    static T pressures[OMWE_BUFFER_SIZE];
+    static T amplitudes[OMWE_BUFFER_SIZE];
+    const char *sample_type = SampleTraits<T>::name();
+    long points = session.omwe_points();
+    for (long i = 0; i < points; i++){
+        pressures[i] = session.omwe_pressure(i);
+        amplitudes[i] = session.omwe_amplitude(i);
+    }
+    bench_stage(report, "bp_calculator", sample_type, points, 100, [&]() {
+        for (int call = 0; call < 100; call++){
+            bench_sink = session.Systolic_and_diastolic_bp_calculator().systolic_bloodpressure;
+        }
+    });
+    MAA_PARAMETERS nearest_parameters = session.parameters();
+    nearest_parameters.envelope_bin_width = 0;
+    bench_stage(report, "bp_calculator_scan", sample_type, points, 100, [&]() {
+        for (int call = 0; call < 100; call++){
+            bench_sink = maa_bp_calculator(pressures, amplitudes, points, session.peak_amplitude(), session.mean_arterial_pressure(),
+                                           nearest_parameters).systolic_bloodpressure;
+        }
+    });
+}
+
+// Stages of the measurement algorithm itself, on a session of sample type T
+template <typename T>
+void bench_algorithm(BENCH_REPORT report) {
+    static MeasurementSession<T> session;
+    const char *sample_type = SampleTraits<T>::name();
+    unsigned long session_samples = bench_run_session(session);
+    bench_stage(report, "process_sample", sample_type, session_samples, session_samples, [&]() {
+        bench_run_session(session);
+    });
+    static PRESSURE_SAMPLE samples[BENCH_SESSION_SAMPLES];
+    for (int i = 0; i < BENCH_SESSION_SAMPLES; i++){
+        PRESSURE_SAMPLE sample = {(unsigned long)i * 20000UL, 0, bench_counts[i], MPR_STATUS_POWERED};
+        samples[i] = sample;
+    }
+    unsigned long block_samples = bench_run_session_blocks(session, samples);
+    bench_stage(report, "process_block", sample_type, PROCESS_BLOCK_SIZE, block_samples, [&]() {
+        bench_run_session_blocks(session, samples);
+    });
+    bench_stage(report, "map_calculator", sample_type, 1, 1000, [&]() {
+        for (int i = 0; i < 1000; i++){
+            session.MAP_calculator();
+        }
+    });
+    long omwe_points = session.omwe_points();
+    bench_stage(report, "pulse_calculator", sample_type, omwe_points, 100, [&]() {
+        for (int i = 0; i < 100; i++){
+            bench_sink = session.measure_pulse().pulse_value;
+        }
+    });
+    bench_bp_calculator(report, session);
+    static const long omwe_sizes[] = {100, 250, 500, OMWE_BUFFER_SIZE};
+    for (unsigned i = 0; i < sizeof(omwe_sizes) / sizeof(omwe_sizes[0]); i++){
+        bench_load_omwe(session, omwe_sizes[i]);
+        bench_bp_calculator(report, session);
+    }
+    bench_stage(report, "session", sample_type, session_samples, 1, [&]() {
+        bench_run_session(session);
+        bench_sink = session.Systolic_and_diastolic_bp_calculator().systolic_bloodpressure + session.measure_pulse().pulse_value;
+    });
+}
+
+void run_benchmarks(BENCH_REPORT report) {
+    bench_build_session();
+
+    bench_convert<double>(report);
+    bench_convert<float>(report);
+    bench_convert<q16_16_t>(report);
+    bench_convert<count_t>(report);
+    bench_normalize<double, 5>(report);
+    bench_normalize<double, 32>(report);
+    bench_normalize<double, 128>(report);
+    bench_normalize<float, 5>(report);
+    bench_normalize<float, 32>(report);
+    bench_normalize<float, 128>(report);
+    bench_normalize<q16_16_t, 5>(report);
+    bench_normalize<q16_16_t, 32>(report);
+    bench_normalize<q16_16_t, 128>(report);
+    bench_normalize<count_t, 5>(report);         // 128 readings of 210 mmHg would overflow the sum of the counts
+    bench_normalize<count_t, 32>(report);
+    bench_filter<double, 1>(report);
+    bench_filter<double, 32>(report);
+    bench_filter<float, 1>(report);
+    bench_filter<float, 32>(report);
+    bench_filter<q16_16_t, 1>(report);
+    bench_filter<q16_16_t, 32>(report);
+    bench_filter<count_t, 1>(report);
+    bench_filter<count_t, 32>(report);
+    bench_algorithm<double>(report);
+    bench_algorithm<float>(report);
+    bench_algorithm<q16_16_t>(report);
+    bench_algorithm<count_t>(report);
+}
@@ -0,0 +1,503 @@
+/*
+* Author(s): Chandra Kiran (cn2255) and Pooja Choudhary (pc3125)
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device 
+* File:       bp_algorithm.cpp
+* Description: Measurement algorithm of the Blood Pressure and Pulse Monitoring system implementing the Maximum Amplitude Algorithm (MAA).
+* As per the MAA algorithm, we first plot the Oscillometric Waveform Envelope (OMWE) graph by plotting the peak values in pressure oscillation.
+* The maxima of the OMWE graph indicate a pressure point called MAP (Mean Arterial Pressure). The Systolic and Diastolic pressure valus could be
+* related to MAP using two characteristic ratio "Rs" (Systolic ratio) and "Rd" (Diastolic ratio).
+* This file has no hardware dependency: it is fed with raw samples by the acquisition code and reports its state through flags, which the
+* target firmware (src/main.cpp) maps to the LEDs and the host build (src/host) evaluates directly. All state belongs to the
+* MeasurementSession object, the session is explicitly instantiated for the three sample types at the end of the file.
+*/
+
+#include "bp_monitor.h"
+#include <math.h>
+#include "cycle_profile.h"
+
+MAA_PARAMETERS maa_default_parameters() {
+    MAA_PARAMETERS parameters;
+    parameters.systolic_lower_ratio = SYSTOLIC_LOWER_CHAR_RATIO;
+    parameters.systolic_upper_ratio = SYSTOLIC_UPPER_CHAR_RATIO;
+    parameters.diastolic_lower_ratio = DIASTOLIC_LOWER_CHAR_RATIO;
+    parameters.diastolic_upper_ratio = DIASTOLIC_UPPER_CHAR_RATIO;
+    parameters.min_omwe_thresh = MIN_OMWE_THRESH;
+    parameters.max_omwe_thresh = MAX_OMWE_THRESH;
+    parameters.map_search_max = MAP_SEARCH_MAX;
+    parameters.map_error_thresh = MAP_ERROR_THRESH;
+    parameters.systolic_search_min = SYSTOLIC_SEARCH_MIN;
+    parameters.systolic_search_max = SYSTOLIC_SEARCH_MAX;
+    parameters.diastolic_search_min = DIASTOLIC_SEARCH_MIN;
+    parameters.diastolic_search_max = DIASTOLIC_SEARCH_MAX;
+    parameters.envelope_bin_width = ENVELOPE_BIN_WIDTH;
+    return parameters;
+}
+
+template <typename T>
+void MeasurementSession<T>::set_calibration(long zero_output) {
+    caliberated_MIN_OUT = zero_output;
+}
+
+// A bin width the sample type rounds to 0, or that does not move the largest graph pressure, can not step through the bins
+template <typename T>
+bool maa_parameters_valid(const MAA_PARAMETERS &parameters) {
+    const T bin_width(parameters.envelope_bin_width), max_pressure(parameters.max_omwe_thresh);
+    return !(parameters.envelope_bin_width > 0) || (bin_width > T(0) && max_pressure + bin_width > max_pressure);
+}
+
+template <typename T>
+bool MeasurementSession<T>::set_parameters(const MAA_PARAMETERS &parameters) {
+    if (!maa_parameters_valid<T>(parameters)){
+        return false;
+    }
+    maa_parameters = parameters;
+    min_omwe_thresh = T(parameters.min_omwe_thresh);
+    max_omwe_thresh = T(parameters.max_omwe_thresh);
+    map_search_max = T(parameters.map_search_max);
+    return true;
+}
+
+/***Function to reset the measurement state*****
+Brings the algorithm back to its power-on state (except the calibration), so several measurements can run one after another. */
+
+template <typename T>
+void MeasurementSession<T>::reset() {
+    current_pressure = T(0);
+    pressure_release_rate = T(0);
+    pressure_filter.reset();
+    pressure_diff = T(0);
+    previous_pressure_diff = T(0);
+    peak_pressure_diff = T(0);
+    Mean_Arterial_Pressure = T(0);
+    omwebuffer_pointer = 0;
+    omwetime_buffer_pointer = 0;
+    omwe_candidate = false;
+    omwe_decimation_count = 0;
+    beat_lobe = false;
+    active_recordflag = false;
+    max_pressure_flag = false;
+    high_release_flag = false;
+    end_record = false;
+}
+
+template <typename T>
+void MeasurementSession<T>::start_recording() {
+    active_recordflag = true;
+}
+
+/***Function to process a block of raw pressure samples*****
+Converts the raw 24 bit sensor outputs into pressure in mmHg, splits them into cuff pressure and oscillation and looks for the peaks of the
+pressure oscillations that make up the OMWE graph. Every stage runs over a whole block of up to PROCESS_BLOCK_SIZE samples before the next
+one, so the conversion and the filter are tight loops without the branches of the peak detection, and the filter is called once per block.
+Only the peak detection and the MAP update depend on the previous sample and run sample by sample. The results are the same as when the
+samples are processed one at a time. Processing stops after the sample that completes the measurement; returns the number of samples
+processed. The normalized pressure of every processed sample is stored in normalized_pressures, if it is not 0. The sample timestamp (and
+not the time of processing) is stored in the OMWE time buffer, so that the pulse evaluation is not affected by how long the sample waited
+in the queue. */
+
+template <typename T>
+long MeasurementSession<T>::process_pressure_block(const PRESSURE_SAMPLE *samples, long count, T *normalized_pressures) {
+    long processed = 0;
+    while (processed < count && !end_record){
+        int block = count - processed < PROCESS_BLOCK_SIZE ? (int)(count - processed) : PROCESS_BLOCK_SIZE;
+        const PRESSURE_SAMPLE *block_samples = samples + processed;
+        for (int i = 0; i < block; i++){
+            block_counts[i] = (int32_t)(block_samples[i].pressure_data - caliberated_MIN_OUT);
+        }
+        PressureConversion<T>::convert(block_counts, block_readings, block);   // Conversion of 24-bit data to pressure reading in mmHg
+        PROFILE_BEGIN(PROFILE_FILTER_UPDATE);
+        pressure_filter.process(block_readings, block_pressures, block_oscillations, block_levels, block);   // Cuff pressure and oscillation of the readings (oscillometric_filter.h)
+        PROFILE_END(PROFILE_FILTER_UPDATE);
+        int i = 0;
+        while (i < block){
+            current_pressure = block_readings[i];
+            analyze_reading(block_samples[i].timestamp_us / 1000, block_pressures[i], block_oscillations[i], block_levels[i]);
+            if (normalized_pressures){
+                normalized_pressures[processed + i] = block_pressures[i];
+            }
+            i++;
+            if (end_record){
+                break;
+            }
+        }
+        processed += i;
+    }
+    return processed;
+}
+
+// One sample, without the block buffers. Returns the normalized pressure.
+template <typename T>
+T MeasurementSession<T>::process_pressure_sample(const PRESSURE_SAMPLE &sample) {
+    T normalized_pressure, oscillation, level;
+    current_pressure = PressureConversion<T>::convert((int32_t)(sample.pressure_data - caliberated_MIN_OUT));
+    PROFILE_BEGIN(PROFILE_FILTER_UPDATE);
+    pressure_filter.process(&current_pressure, &normalized_pressure, &oscillation, &level, 1);
+    PROFILE_END(PROFILE_FILTER_UPDATE);
+    analyze_reading(sample.timestamp_us / 1000, normalized_pressure, oscillation, level);
+    return normalized_pressure;
+}
+
+// Peak detection, MAP update and end of measurement check of one converted and filtered reading. level is the filter value() after it.
+// The largest peak of every OMWE_DECIMATION readings is kept as candidate and stored after the last of them (at 50 Hz every peak is
+// stored right away), so the graph gets at most OMWE_MAX_POINT_RATE points per second at any sample rate. The graph holds several peaks
+// per heart beat, so the beats for the pulse are taken from the oscillation itself: the maximum of every positive half wave.
+template <typename T>
+void MeasurementSession<T>::analyze_reading(unsigned long Time_ms, T normalized_pressure, T oscillation, T level) {
+    PROFILE_BEGIN(PROFILE_OMWE_PEAK_CHECK);
+     if (active_recordflag) {
+         if (sample_abs(oscillation) < T(12.0)) {   // If the button is pressed and data read is viable, record the readings
+            pressure_diff = sample_abs(oscillation);   // Difference pressure is the change in the peak of current to normalised pressure
+            if (normalized_pressure > min_omwe_thresh && normalized_pressure < max_omwe_thresh){
+                if (pressure_diff < previous_pressure_diff && (!omwe_candidate || previous_pressure_diff > omwe_candidate_amplitude)){   // Condition to check if the graph passed a maxima that has to be stored
+                    omwe_candidate = true;
+                    omwe_candidate_amplitude = previous_pressure_diff;
+                    omwe_candidate_pressure = normalized_pressure;
+                }
+                if (oscillation > T(0)){
+                    if (!beat_lobe || oscillation > beat_amplitude){
+                        beat_amplitude = oscillation;
+                        beat_time = Time_ms;
+                    }
+                    beat_lobe = true;
+                }
+                else if (beat_lobe){
+                    beat_lobe = false;
+                    store_beat();
+                }
+            }
+            previous_pressure_diff = pressure_diff;
+         }
+         if (++omwe_decimation_count >= OMWE_DECIMATION){
+             omwe_decimation_count = 0;
+             store_omwe_candidate();
+         }
+     }
+    PROFILE_END(PROFILE_OMWE_PEAK_CHECK);
+    PROFILE_BEGIN(PROFILE_MAP_UPDATE);
+    update_map(level);             // MAP calculater is called to check, if the passed maxima is the absolute maxima in the OMWE for which we have to store as MAP value
+    PROFILE_END(PROFILE_MAP_UPDATE);
+     if (normalized_pressure > T(INFLATION_PRESSURE)){    // At the upper limit of 200.0 mmHg pressure, a motification is send to release the pressure in the pump and record data for OMWE
+          max_pressure_flag = true;  
+         }      // If red LED is ON, It is indicating Maximum pressure 
+     if (active_recordflag && normalized_pressure < T(5.0)){   // if the pressure is dropped less than 5 mmHg andIf the active flag used for rate measurement is active and , we can now stop pressure measurement
+         end_record = true;
+     } 
+}
+
+// Appends the peak candidate to the OMWE graph, as long as it has room
+template <typename T>
+void MeasurementSession<T>::store_omwe_candidate() {
+    if (!omwe_candidate){
+        return;
+    }
+    omwe_candidate = false;
+    if (omwebuffer_pointer >= OMWE_BUFFER_SIZE){
+        return;
+    }
+    omwegraph_ordinate_buffer[omwebuffer_pointer] = omwe_candidate_amplitude;
+    omwegraph_absicissa_buffer[omwebuffer_pointer++] = omwe_candidate_pressure;
+}
+
+// Appends the maximum of the half wave that just ended to the OMWE time buffer. A half wave within BEAT_REFRACTORY_MS of the latest beat
+// belongs to the same beat (noise around the zero crossings, the foot of the upstroke) and replaces it only if its maximum is larger.
+template <typename T>
+void MeasurementSession<T>::store_beat() {
+    if (omwetime_buffer_pointer > 0 && beat_time - omwe_buffer_time[omwetime_buffer_pointer - 1] < BEAT_REFRACTORY_MS){
+        if (beat_amplitude > omwe_beat_buffer[omwetime_buffer_pointer - 1]){
+            omwe_buffer_time[omwetime_buffer_pointer - 1] = beat_time;
+            omwe_beat_buffer[omwetime_buffer_pointer - 1] = beat_amplitude;
+        }
+    }
+    else if (omwetime_buffer_pointer < BEAT_BUFFER_SIZE){
+        omwe_buffer_time[omwetime_buffer_pointer] = beat_time;
+        omwe_beat_buffer[omwetime_buffer_pointer++] = beat_amplitude;
+    }
+}
+
+/***Fuction to Measure Pulse using the OMWE graph time buffer*********
+OMWE time buffer collects the time and the oscillation maximum of every detected heart beat.
+This routine checks for the time between consecutive beats and then checks if it comes under reliable pulse rate. Only beats that reach
+min_amplitude are used: far from MAP the oscillation is small and the noise adds and splits beats.
+Multiple such reliable data points are found and the average is taken to be the pulse value.
+The pulse_count gives the total number of pulse time data points using which the final pulse was evaluated.  */
+
+template <typename T>
+PULSE_READING maa_pulse_calculator(const unsigned long *peak_times_ms, const T *amplitudes, long points, T min_amplitude) {
+    PULSE_READING pulse_data;
+    double pulse_upper_value = (60.0/LOWER_PULSE_RANGE)*1000.0;        // Upper value of pulse in time difference between the consecutive pulse peaks
+    double pulse_lower_value = (60.0/UPPER_PULSE_RANGE)*1000.0;        // Lower value of pulse in time difference between the consecutive pulse peaks
+    double pulse = 0.0;
+    double pulse_time_p2p;
+    long pulse_count = 0;
+    for (long i = 1; i < points; i++){
+        if (amplitudes[i] < min_amplitude || amplitudes[i - 1] < min_amplitude){
+            continue;
+        }
+        pulse_time_p2p = (double)(peak_times_ms[i] - peak_times_ms[i - 1]);   // Time interval between adjactent peaks
+        if (pulse_time_p2p > pulse_lower_value && pulse_time_p2p < pulse_upper_value){
+            pulse += pulse_time_p2p;
+            pulse_count++;
+        }
+    }
+    if (pulse_count != 0){
+        pulse /= (double)pulse_count;
+        pulse = (1000/pulse) * (60.0);
+    }
+    else {
+        pulse = -1;
+    }
+    pulse_data.pulse_value = pulse;
+    pulse_data.pulse_data_count = pulse_count;   
+    return pulse_data; 
+}
+
+template <typename T>
+PULSE_READING MeasurementSession<T>::measure_pulse() const {
+    return maa_pulse_calculator(omwe_buffer_time, omwe_beat_buffer, omwetime_buffer_pointer, T((double)peak_pressure_diff * PULSE_AMPLITUDE_RATIO));
+}
+
+/*****Fuction to Systolic and Diastolic Pressure using OMWE graph X and Y cordinates  
+Useing MAA Algorithm to evaluate Systolic and Diastolic blood pressure values. 
+As a part of this, during the measure_pressure routine,the MAP (Mean Arterial Pressure) value would be found and the OMWE graph would be plotted after the user manually gestures the controller to start plotting by pressing
+the USER button. 
+The MAA algorithm tells that :
+Systolic Pressure = Pressure value (x cordinate) corresponding to (Rs*MAP) y cordinate in OMWE graph toward right of MAP peak. 
+Diastolic value corresponds to the pressure value at (Rd*MAP). 
+Here Rs and Rd are Systolic and Diastolic characteristic ratios. 
+Assuming Rs = (0.45 + 0.73)/2 = 0.59 and Rd = (0.69 + 0.83)/2 = 0.76 BP estimation using MAA algorithm.
+The ratio bounds, MAP_ERROR_THRESH and the reliable pressure ranges come from MAA_PARAMETERS (defaults in bp_config.h).
+With an envelope bin width the pressures are interpolated where the envelope crosses the characteristic amplitudes (maa_envelope_crossing),
+otherwise the abscissa of the closest graph point within MAP_ERROR_THRESH is taken, the first one found with the smallest distance. ****/
+
+// Characteristic amplitudes (OMWE graph y values) of the systolic and diastolic pressure
+template <typename T>
+static void maa_characteristic_amplitudes(T peak_amplitude, const MAA_PARAMETERS &parameters, T &systolic_ordinate_value, T &diastolic_ordinate_value) {
+    T lower_systolic, upper_systolic, lower_diastolic, upper_diastolic;
+    // Here peak delta pressure corresponds to the ordinate of OMWE graph(Y-axis) corresponding to x
+    lower_systolic = T(parameters.systolic_lower_ratio) * peak_amplitude;
+    upper_systolic = T(parameters.systolic_upper_ratio) * peak_amplitude;
+    lower_diastolic = T(parameters.diastolic_lower_ratio) * peak_amplitude;
+    upper_diastolic = T(parameters.diastolic_upper_ratio) * peak_amplitude;
+    systolic_ordinate_value = (lower_systolic + upper_systolic)/2;           // Pressure peak value corresponding to Systolic pressure
+    diastolic_ordinate_value = (lower_diastolic + upper_diastolic)/2;        // Pressure peak value corresponding to Diastolic pressure
+}
+
+template <typename T>
+static BP_PARAMETER maa_bp_result(bool reliable, T systolic_pressure, T min_systolic_ordinate_error, T diastolic_pressure, T min_diastolic_ordinate_error) {
+    BP_PARAMETER bp_value;
+    // If pressure value found isn't reliable, set the pressure values to negative so that, we will be prompted to reconduct the test.
+    if (!reliable){
+        bp_value.systolic_bloodpressure = -1;
+        bp_value.diastolic_bloodpressure = -1;
+        bp_value.diastolic_char_ratio = (double)min_diastolic_ordinate_error;
+        bp_value.systolic_char_ratio = (double)min_systolic_ordinate_error;
+    }
+    // Else load the bp values with the respective pressure values and the deviation of the found y value from the extected characteristic y value
+    else {
+        bp_value.systolic_bloodpressure = (double)systolic_pressure;
+        bp_value.diastolic_bloodpressure = (double)diastolic_pressure;
+        bp_value.diastolic_char_ratio = (double)min_diastolic_ordinate_error;
+        bp_value.systolic_char_ratio = (double)min_systolic_ordinate_error;        
+    }
+    return bp_value;
+}
+
+template <typename T>
+static BP_PARAMETER maa_bp_result(const T *pressures, long systolic_buffer, T min_systolic_ordinate_error, long diastolic_buffer, T min_diastolic_ordinate_error) {
+    bool reliable = systolic_buffer >= 0 && diastolic_buffer >= 0;
+    return maa_bp_result(reliable, reliable ? pressures[systolic_buffer] : T(0), min_systolic_ordinate_error,
+                         reliable ? pressures[diastolic_buffer] : T(0), min_diastolic_ordinate_error);
+}
+
+/***Function to find where the envelope crosses a characteristic amplitude*****
+Walks the OMWE graph from MAP outward: towards higher pressures (direction -1, the graph is recorded while the pressure falls) for the
+systolic and towards lower pressures (direction 1) for the diastolic pressure. The graph holds several peaks per heart beat, most of them
+small noise peaks, so the points of every bin_width wide pressure bin (counted from MAP) are merged into the largest one, which follows
+the upper envelope. The pressure where this envelope falls below target is interpolated linearly between the last envelope point above
+and the first one below it, the first of them being MAP itself, so the result does not snap to a recorded point and a sparse graph (low
+sample rate) still gives a reading. deviation is the distance of the closer of the two envelope points from target. Returns false if the
+graph ends before the envelope falls below target. */
+
+// Bin of pressure, counted in bin_width steps from map in the search direction (0: the bin next to MAP)
+template <typename T>
+static long maa_envelope_bin(T pressure, T map, int direction, T bin_width) {
+    return (long)floor((double)(direction > 0 ? map - pressure : pressure - map) / (double)bin_width);
+}
+
+template <typename T>
+static bool maa_envelope_crossing(const T *pressures, const T *amplitudes, long points, long start, int direction, T map, T peak_amplitude,
+                                  T target, T bin_width, T &crossing, T &deviation) {
+    T previous_pressure = map, previous_amplitude = peak_amplitude;      // Last envelope point at or above target
+    T bin_pressure(0), bin_amplitude(0);
+    bool bin_used = false;
+    long bin = 0;                                                       // Bin of bin_pressure, the bins without points are skipped
+    for (long i = start; ; i += direction){
+        bool end = i < 0 || i >= points;
+        long point_bin = end ? bin : maa_envelope_bin(pressures[i], map, direction, bin_width);
+        if ((end || point_bin > bin) && bin_used){
+            if (bin_amplitude < target){
+                crossing = previous_pressure + (bin_pressure - previous_pressure) * ((previous_amplitude - target) / (previous_amplitude - bin_amplitude));
+                deviation = previous_amplitude - target < target - bin_amplitude ? previous_amplitude - target : target - bin_amplitude;
+                return true;
+            }
+            previous_pressure = bin_pressure;
+            previous_amplitude = bin_amplitude;
+            bin_used = false;
+        }
+        if (end){
+            return false;
+        }
+        if (point_bin > bin){
+            bin = point_bin;
+        }
+        if (!bin_used || amplitudes[i] > bin_amplitude){
+            bin_pressure = pressures[i];
+            bin_amplitude = amplitudes[i];
+            bin_used = true;
+        }
+    }
+}
+
+// Systolic and diastolic pressure from the envelope crossings, bin_width > 0
+template <typename T>
+static BP_PARAMETER maa_bp_crossings(const T *pressures, const T *amplitudes, long points, T peak_amplitude, T map, T bin_width,
+                                     const MAA_PARAMETERS &parameters) {
+    T systolic_ordinate_value, diastolic_ordinate_value;
+    T systolic_pressure(0), diastolic_pressure(0);
+    T systolic_deviation(parameters.map_error_thresh + 1), diastolic_deviation(parameters.map_error_thresh + 1);
+    maa_characteristic_amplitudes(peak_amplitude, parameters, systolic_ordinate_value, diastolic_ordinate_value);
+    long first_below_map = 0, last = points;       // The graph falls in pressure, the first point below MAP is found by bisection
+    while (first_below_map < last){
+        long middle = (first_below_map + last) / 2;
+        if (pressures[middle] < map){
+            last = middle;
+        }
+        else {
+            first_below_map = middle + 1;
+        }
+    }
+    bool reliable = maa_envelope_crossing(pressures, amplitudes, points, first_below_map - 1, -1, map, peak_amplitude, systolic_ordinate_value,
+                                          bin_width, systolic_pressure, systolic_deviation) &&
+                    maa_envelope_crossing(pressures, amplitudes, points, first_below_map, 1, map, peak_amplitude, diastolic_ordinate_value,
+                                          bin_width, diastolic_pressure, diastolic_deviation);
+    reliable = reliable && systolic_pressure > T(parameters.systolic_search_min) && systolic_pressure < T(parameters.systolic_search_max) &&
+               diastolic_pressure > T(parameters.diastolic_search_min) && diastolic_pressure < T(parameters.diastolic_search_max);
+    return maa_bp_result(reliable, systolic_pressure, systolic_deviation, diastolic_pressure, diastolic_deviation);
+}
+
+// Nearest point by a linear search over the graph
+template <typename T>
+BP_PARAMETER maa_bp_calculator(const T *pressures, const T *amplitudes, long points, T peak_amplitude, T map, const MAA_PARAMETERS &parameters) {
+    const T bin_width(parameters.envelope_bin_width);
+    if (bin_width > T(0)){
+        return maa_bp_crossings(pressures, amplitudes, points, peak_amplitude, map, bin_width, parameters);
+    }
+    T systolic_ordinate_value, diastolic_ordinate_value;
+    long systolic_buffer = -1, diastolic_buffer = -1;
+    T min_systolic_ordinate_error(parameters.map_error_thresh + 1);
+    T min_diastolic_ordinate_error(parameters.map_error_thresh + 1);
+    const T systolic_min(parameters.systolic_search_min), systolic_max(parameters.systolic_search_max);
+    const T diastolic_min(parameters.diastolic_search_min), diastolic_max(parameters.diastolic_search_max);
+    maa_characteristic_amplitudes(peak_amplitude, parameters, systolic_ordinate_value, diastolic_ordinate_value);
+    
+    // min_systolic_ordinate_error/min_diastolic_ordinate_error are used to find the closest y value in OMWE graph that matches with the characteristic pressure peaks
+    for (long i = 0; i < points; i++){
+        if (sample_abs(amplitudes[i] -  systolic_ordinate_value) < min_systolic_ordinate_error){
+           if(pressures[i] > systolic_min && pressures[i] < systolic_max) {          // Filter to check if pressure is reliable
+              min_systolic_ordinate_error = sample_abs(amplitudes[i] -  systolic_ordinate_value);
+              systolic_buffer = i;
+           }   
+        }
+        if (sample_abs(amplitudes[i] -  diastolic_ordinate_value) < min_diastolic_ordinate_error){
+           if(pressures[i] > diastolic_min && pressures[i] < diastolic_max) { 
+              min_diastolic_ordinate_error = sample_abs(amplitudes[i] -  diastolic_ordinate_value);
+              diastolic_buffer = i;
+           }   
+        }        
+    }
+    return maa_bp_result(pressures, systolic_buffer, min_systolic_ordinate_error, diastolic_buffer, min_diastolic_ordinate_error);
+}
+
+template <typename T>
+BP_PARAMETER MeasurementSession<T>::Systolic_and_diastolic_bp_calculator() const {
+    return maa_bp_calculator(omwegraph_absicissa_buffer, omwegraph_ordinate_buffer, omwebuffer_pointer, peak_pressure_diff,
+                             Mean_Arterial_Pressure, maa_parameters);
+}
+
+
+/* Function check for MAP values on the go as the data is being collected 
+While the meaure_pressure funciton is running and the USER button (input from user) has been pressed the controller keeps checking for the event of a peak
+pressure change. The normalized pressure value corresponding to the peak change is the MAP value. */
+
+template <typename T>
+void MeasurementSession<T>::MAP_calculator() {
+    update_map(pressure_filter.value());
+}
+
+template <typename T>
+void MeasurementSession<T>::update_map(T normalized_pressure) {
+    if (pressure_diff > peak_pressure_diff && normalized_pressure > min_omwe_thresh && normalized_pressure < map_search_max){        
+        peak_pressure_diff = pressure_diff;     // The peak ordinate corresponding to MAP value in OMWE
+        Mean_Arterial_Pressure = normalized_pressure;   // The MAP pressure value
+    }
+    
+}
+
+/***Function to check for an increased pressure release rate*****
+If the release rate is found high, the high release rate flag is set true, which lights up the BLUE LED6 */
+
+template <typename T>
+void MeasurementSession<T>::check_pressure_gradient() {
+  if (pressure_filter.full()){
+      pressure_release_rate = pressure_filter.value() - current_pressure;  // The difference between current pressure and the normalized pressure, depicts a change in release rate
+      if (pressure_release_rate > T(4.0)){                                       
+         high_release_flag = true;     // For high release rate flux warning makes warning LED to ON
+      }
+      else {
+          high_release_flag = false;   //The LED will be OFF if the release rate is normal.
+      }
+  }
+}
+
+/***Function to load an OMWE graph*****
+Replaces the recorded OMWE graph with the given points and looks up its MAP the way MAP_calculator() does during the measurement, so the
+systolic/diastolic calculator can be run on a graph that was extracted earlier. The time buffer is cleared, the pulse is not evaluated. */
+
+template <typename T>
+void MeasurementSession<T>::load_omwe_graph(const T *pressures, const T *amplitudes, long points) {
+    if (points > OMWE_BUFFER_SIZE){
+        points = OMWE_BUFFER_SIZE;
+    }
+    peak_pressure_diff = T(0);
+    Mean_Arterial_Pressure = T(0);
+    for (long i = 0; i < points; i++){
+        omwegraph_absicissa_buffer[i] = pressures[i];
+        omwegraph_ordinate_buffer[i] = amplitudes[i];
+        if (amplitudes[i] > peak_pressure_diff && pressures[i] > min_omwe_thresh && pressures[i] < map_search_max){
+            peak_pressure_diff = amplitudes[i];
+            Mean_Arterial_Pressure = pressures[i];
+        }
+    }
+    omwebuffer_pointer = points;
+    omwetime_buffer_pointer = 0;
+    omwe_candidate = false;
+    omwe_decimation_count = 0;
+    beat_lobe = false;
+}
+
+template BP_PARAMETER maa_bp_calculator(const double *, const double *, long, double, double, const MAA_PARAMETERS &);
+template BP_PARAMETER maa_bp_calculator(const float *, const float *, long, float, float, const MAA_PARAMETERS &);
+template BP_PARAMETER maa_bp_calculator(const q16_16_t *, const q16_16_t *, long, q16_16_t, q16_16_t, const MAA_PARAMETERS &);
+template BP_PARAMETER maa_bp_calculator(const count_t *, const count_t *, long, count_t, count_t, const MAA_PARAMETERS &);
+template PULSE_READING maa_pulse_calculator(const unsigned long *, const double *, long, double);
+template PULSE_READING maa_pulse_calculator(const unsigned long *, const float *, long, float);
+template PULSE_READING maa_pulse_calculator(const unsigned long *, const q16_16_t *, long, q16_16_t);
+template PULSE_READING maa_pulse_calculator(const unsigned long *, const count_t *, long, count_t);
+template bool maa_parameters_valid<double>(const MAA_PARAMETERS &);
+template bool maa_parameters_valid<float>(const MAA_PARAMETERS &);
+template bool maa_parameters_valid<q16_16_t>(const MAA_PARAMETERS &);
+template bool maa_parameters_valid<count_t>(const MAA_PARAMETERS &);
+template class MeasurementSession<double>;
+template class MeasurementSession<float>;
+template class MeasurementSession<q16_16_t>;
+template class MeasurementSession<count_t>;
@@ -0,0 +1,40 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       cycle_profile.cpp
+* Description: Statistics and report of the stage instrumentation, see cycle_profile.h.
+*/
+
+#include "cycle_profile.h"
+#include <string.h>
+
+CYCLE_STATS cycle_profile[PROFILE_STAGE_COUNT];
+
+static const char *const profile_stage_names[PROFILE_STAGE_COUNT] = {
+    "SPI exchange", "Filter update", "OMWE peak check", "MAP update", "Gradient ISR", "Gradient check"
+};
+
+void cycle_profile_reset() {
+    memset(cycle_profile, 0, sizeof(cycle_profile));
+}
+
+/***Function to print the stage statistics*****
+For every stage that was timed prints the number of runs with the minimum, mean and maximum duration, followed by the non-empty bins of the
+log2 histogram as "<2^k:count". The histogram shows whether a high maximum is a rare outlier or a second mode of the distribution. */
+
+void cycle_profile_print(PROFILE_PRINTF print) {
+    for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++){
+        const CYCLE_STATS &stats = cycle_profile[stage];
+        if (stats.count == 0){
+            continue;
+        }
+        print("\n %s: n = %lu, min = %lu, mean = %lu, max = %lu %s", profile_stage_names[stage], (unsigned long)stats.count,
+              (unsigned long)stats.min, (unsigned long)(stats.total / stats.count), (unsigned long)stats.max, hal_bench_unit());
+        print("\n   histogram:");
+        for (int bin = 0; bin < CYCLE_HISTOGRAM_BINS; bin++){
+            if (stats.histogram[bin]){
+                print(bin == CYCLE_HISTOGRAM_BINS - 1 ? " >=2^%d:%lu" : " <2^%d:%lu", bin == CYCLE_HISTOGRAM_BINS - 1 ? bin - 1 : bin,
+                      (unsigned long)stats.histogram[bin]);
+            }
+        }
+    }
+}
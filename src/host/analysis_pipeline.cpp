@@ -0,0 +1,258 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       analysis_pipeline.cpp
+* Description: Staged analysis with content hashed intermediate results, see analysis_pipeline.h.
+*/
+
+#include "analysis_pipeline.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "batch_analyzer.h"
+
+// Cache files hold the raw bytes of the result, they are only read back by the same build (the key covers the sample type)
+template <typename V>
+static void encode(std::string &out, const V &value) {
+    out.append((const char *)&value, sizeof(value));
+}
+
+template <typename V>
+static bool decode(const std::string &in, size_t &offset, V &value) {
+    if (in.size() - offset < sizeof(value)){
+        return false;
+    }
+    memcpy(&value, in.data() + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+
+template <typename V>
+static void encode(std::string &out, const std::vector<V> &values) {
+    encode(out, (uint32_t)values.size());
+    out.append((const char *)values.data(), values.size() * sizeof(V));
+}
+
+template <typename V>
+static bool decode(const std::string &in, size_t &offset, std::vector<V> &values) {
+    uint32_t count;
+    if (!decode(in, offset, count) || (in.size() - offset) / sizeof(V) < count){
+        return false;
+    }
+    values.resize(count);
+    memcpy(values.data(), in.data() + offset, count * sizeof(V));
+    offset += count * sizeof(V);
+    return true;
+}
+
+static void encode(std::string &out, const OMWE_ENVELOPE<sample_t> &envelope) {
+    encode(out, envelope.samples);
+    encode(out, envelope.complete);
+    encode(out, envelope.truncated);
+    encode(out, envelope.pressures);
+    encode(out, envelope.amplitudes);
+    encode(out, envelope.peak_times_ms);
+    encode(out, envelope.peak_amplitudes);
+    encode(out, envelope.track_pressures);
+    encode(out, envelope.track_amplitudes);
+}
+
+static bool decode(const std::string &in, size_t &offset, OMWE_ENVELOPE<sample_t> &envelope) {
+    return decode(in, offset, envelope.samples) && decode(in, offset, envelope.complete) && decode(in, offset, envelope.truncated) &&
+           decode(in, offset, envelope.pressures) && decode(in, offset, envelope.amplitudes) && decode(in, offset, envelope.peak_times_ms) &&
+           decode(in, offset, envelope.peak_amplitudes) &&
+           decode(in, offset, envelope.track_pressures) && decode(in, offset, envelope.track_amplitudes);
+}
+
+AnalysisPipeline::AnalysisPipeline(const char *cache_directory) : directory(cache_directory ? cache_directory : "") {
+    memset(stage_stats, 0, sizeof(stage_stats));
+}
+
+const char *AnalysisPipeline::stage_name(PIPELINE_STAGE stage) {
+    static const char *const names[PIPELINE_STAGES] = {"calibration", "envelope", "map", "bp", "pulse"};
+    return names[stage];
+}
+
+std::string AnalysisPipeline::cache_path(PIPELINE_STAGE stage, uint64_t key) const {
+    char name[40];
+    snprintf(name, sizeof(name), "/%016llx.", (unsigned long long)key);
+    return directory + name + stage_name(stage);
+}
+
+template <typename V>
+bool AnalysisPipeline::lookup(PIPELINE_STAGE stage, uint64_t key, std::unordered_map<uint64_t, V> &memory, V &value) {
+    typename std::unordered_map<uint64_t, V>::const_iterator found = memory.find(key);
+    if (found != memory.end()){
+        value = found->second;
+        stage_stats[stage].memory_hits++;
+        return true;
+    }
+    if (directory.empty()){
+        return false;
+    }
+    FILE *file = fopen(cache_path(stage, key).c_str(), "rb");
+    if (!file){
+        return false;
+    }
+    std::string content;
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0){
+        content.append(buffer, read);
+    }
+    fclose(file);
+    size_t offset = 0;
+    if (!decode(content, offset, value) || offset != content.size()){
+        return false;               // Damaged or from another build: computed again and overwritten
+    }
+    memory[key] = value;
+    stage_stats[stage].disk_hits++;
+    return true;
+}
+
+template <typename V>
+void AnalysisPipeline::store(PIPELINE_STAGE stage, uint64_t key, std::unordered_map<uint64_t, V> &memory, const V &value) {
+    memory[key] = value;
+    stage_stats[stage].computed++;
+    if (directory.empty()){
+        return;
+    }
+    std::string content;
+    encode(content, value);
+    std::string path = cache_path(stage, key);
+    std::string temporary = path + ".tmp";
+    FILE *file = fopen(temporary.c_str(), "wb");
+    if (!file){
+        return;                     // The cache directory is optional, a read only one only costs the reuse
+    }
+    bool written = fwrite(content.data(), 1, content.size(), file) == content.size();
+    if (fclose(file) == 0 && written){
+        rename(temporary.c_str(), path.c_str());      // Readers never see a partially written result
+    }
+    else {
+        remove(temporary.c_str());
+    }
+}
+
+SESSION_RESULT AnalysisPipeline::analyze(const SESSION &session, const MAA_PARAMETERS &parameters) {
+    ContentHash readings;
+    readings.add((int)ANALYSIS_CACHE_VERSION).add(SampleTraits<sample_t>::name(), strlen(SampleTraits<sample_t>::name()));
+    readings.add((int)NORMALIZE_WINDOW).add((int)OMWE_BUFFER_SIZE).add((int)CALIBRATION_SAMPLES).add(session.sample_rate_hz);
+    readings.add((int)PRESSURE_FILTER).add((int)SAMPLE_RATE_HZ).add((double)CUFF_LOWPASS_HZ).add((double)OSCILLATION_LOW_HZ)
+            .add((double)OSCILLATION_HIGH_HZ);
+    readings.add(CuffSensor::output_min()).add(CuffSensor::output_max()).add(CuffSensor::pressure_min()).add(CuffSensor::pressure_max());
+    readings.add(session.samples.size()).add(session.events.size());
+    for (size_t i = 0; i < session.samples.size(); i++){
+        readings.add(session.samples[i].timestamp_us).add(session.samples[i].pressure_data).add(session.samples[i].status);
+    }
+    for (size_t i = 0; i < session.events.size(); i++){
+        readings.add(session.events[i].timestamp_us).add(session.events[i].pressure_data);
+    }
+
+    long zero_output;
+    uint64_t calibration_key = ContentHash().add(readings.value()).add((int)PIPELINE_CALIBRATION).value();
+    if (!lookup(PIPELINE_CALIBRATION, calibration_key, calibrations, zero_output)){
+        zero_output = session_calibration(session);
+        store(PIPELINE_CALIBRATION, calibration_key, calibrations, zero_output);
+    }
+
+    OMWE_ENVELOPE<sample_t> envelope;
+    uint64_t envelope_key = ContentHash().add(readings.value()).add((int)PIPELINE_ENVELOPE).add(zero_output)
+                                         .add(parameters.min_omwe_thresh).add(parameters.max_omwe_thresh).value();
+    if (!lookup(PIPELINE_ENVELOPE, envelope_key, envelopes, envelope)){
+        measurement.set_parameters(parameters);
+        extract_envelope(session, zero_output, measurement, envelope);
+        store(PIPELINE_ENVELOPE, envelope_key, envelopes, envelope);
+    }
+
+    MAP_RESULT map;
+    uint64_t map_key = ContentHash().add(envelope_key).add((int)PIPELINE_MAP).add(parameters.min_omwe_thresh)
+                                    .add(parameters.map_search_max).value();
+    if (!lookup(PIPELINE_MAP, map_key, maps, map)){
+        map.map = envelope_map(envelope, parameters, map.peak_amplitude);
+        store(PIPELINE_MAP, map_key, maps, map);
+    }
+
+    SESSION_RESULT result;
+    uint64_t bp_key = ContentHash().add(envelope_key).add((int)PIPELINE_BP).add(map.map).add(map.peak_amplitude)
+                                   .add(parameters.systolic_lower_ratio).add(parameters.systolic_upper_ratio)
+                                   .add(parameters.diastolic_lower_ratio).add(parameters.diastolic_upper_ratio)
+                                   .add(parameters.map_error_thresh).add(parameters.systolic_search_min).add(parameters.systolic_search_max)
+                                   .add(parameters.diastolic_search_min).add(parameters.diastolic_search_max)
+                                   .add(parameters.envelope_bin_width).value();
+    if (!lookup(PIPELINE_BP, bp_key, bps, result.bp)){
+        // The envelope was extracted with the thresholds of parameters, so its graph is used as it is
+        result.bp = maa_bp_calculator(envelope.pressures.data(), envelope.amplitudes.data(), (long)envelope.pressures.size(),
+                                      map.peak_amplitude, map.map, parameters);
+        store(PIPELINE_BP, bp_key, bps, result.bp);
+    }
+
+    uint64_t pulse_key = ContentHash().add(envelope_key).add((int)PIPELINE_PULSE).add(map.peak_amplitude).value();
+    if (!lookup(PIPELINE_PULSE, pulse_key, pulses, result.pulse)){
+        result.pulse = maa_pulse_calculator(envelope.peak_times_ms.data(), envelope.peak_amplitudes.data(), (long)envelope.peak_times_ms.size(),
+                                            sample_t((double)map.peak_amplitude * PULSE_AMPLITUDE_RATIO));
+        store(PIPELINE_PULSE, pulse_key, pulses, result.pulse);
+    }
+
+    result.samples = envelope.samples;
+    result.complete = envelope.complete;
+    result.mean_arterial_pressure = (double)map.map;
+    return result;
+}
+
+int analyze(int argc, char **argv) {
+    std::vector<std::string> files;
+    const char *cache_directory = 0;
+    MAA_PARAMETERS parameters = maa_default_parameters();
+    for (int i = 0; i < argc; i++){
+        if (!strcmp(argv[i], "--cache") && i + 1 < argc){
+            cache_directory = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--set") && i + 1 < argc){
+            const char *setting = argv[++i];
+            const char *equals = strchr(setting, '=');
+            double MAA_PARAMETERS::*member = equals ? maa_parameter(setting, equals - setting) : 0;
+            if (!member){
+                fprintf(stderr, "Invalid setting %s\n", setting);
+                return 2;
+            }
+            parameters.*member = atof(equals + 1);
+        }
+        else if (!collect_sessions(argv[i], files)){
+            return 2;
+        }
+    }
+    if (files.empty()){
+        fprintf(stderr, "Usage: analyze DIR_OR_FILE... [--cache DIR] [--set NAME=VALUE]...\n");
+        return 2;
+    }
+    if (!maa_parameters_valid<sample_t>(parameters)){
+        fprintf(stderr, "envelope_bin_width %g is below the resolution of the sample type\n", parameters.envelope_bin_width);
+        return 2;
+    }
+
+    AnalysisPipeline pipeline(cache_directory);
+    unsigned long analyzed = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    printf("file,samples,complete,systolic,diastolic,map,systolic_deviation,diastolic_deviation,pulse,pulse_intervals\n");
+    for (size_t i = 0; i < files.size(); i++){
+        SESSION session;
+        if (!session_load(files[i].c_str(), session) || !session_rate_supported(files[i].c_str(), session)){
+            continue;
+        }
+        SESSION_RESULT result = pipeline.analyze(session, parameters);
+        printf("%s,%lu,%d,%.3f,%.3f,%.3f,%.4f,%.4f,%.3f,%ld\n", files[i].c_str(), result.samples, result.complete ? 1 : 0,
+               result.bp.systolic_bloodpressure, result.bp.diastolic_bloodpressure, result.mean_arterial_pressure,
+               result.bp.systolic_char_ratio, result.bp.diastolic_char_ratio, result.pulse.pulse_value, result.pulse.pulse_data_count);
+        analyzed++;
+    }
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "sessions = %lu analyzed (%lu unreadable or at another rate), wall time = %.3f s\n", analyzed, (unsigned long)files.size() - analyzed, wall_s);
+    for (int stage = 0; stage < PIPELINE_STAGES; stage++){
+        const PIPELINE_STAGE_STATS &stats = pipeline.stats((PIPELINE_STAGE)stage);
+        fprintf(stderr, "%-12s computed = %lu, memory hits = %lu, disk hits = %lu\n", AnalysisPipeline::stage_name((PIPELINE_STAGE)stage),
+                stats.computed, stats.memory_hits, stats.disk_hits);
+    }
+    return analyzed == files.size() ? 0 : 1;
+}
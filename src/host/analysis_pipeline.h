@@ -0,0 +1,109 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       analysis_pipeline.h
+* Description: Incremental analysis of recorded sessions. The analysis is split into stages whose results are cached under a content hash
+* of everything they depend on:
+*
+*   readings -> calibration -> envelope (conversion, normalization, OMWE peaks and graph) -> MAP -> systolic/diastolic pressure
+*                                                                                         \-> pulse (OMWE peak times)
+*
+* The key of a stage hashes the key of the stage it reads, the values it takes from the stages before and its own parameters, so changing
+* a parameter only recomputes the stage that uses it and the stages after it: with other characteristic ratios only the systolic/diastolic
+* stage runs, with other OMWE thresholds the session is processed again. The readings to envelope stages are one stage here because the
+* algorithm processes every reading through all of them in a single pass, as it does on the target.
+*
+* Results are kept in memory and, with a cache directory, in one file per result, so later runs of the analyze command reuse them. The key
+* also covers the sample type and the build time configuration (PRESSURE_FILTER and its settings, OMWE_BUFFER_SIZE, CALIBRATION_SAMPLES); raise
+* ANALYSIS_CACHE_VERSION when the algorithm itself changes. Cached files are never removed by the program. A pipeline must only be used
+* by one thread at a time.
+*
+* Usage: program analyze DIR_OR_FILE... [--cache DIR] [--set NAME=VALUE]... > results.csv     (NAME as for program sweep)
+*/
+
+#ifndef ANALYSIS_PIPELINE_H
+#define ANALYSIS_PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include "session_analysis.h"
+
+#define ANALYSIS_CACHE_VERSION 4
+
+enum PIPELINE_STAGE {
+    PIPELINE_CALIBRATION,
+    PIPELINE_ENVELOPE,
+    PIPELINE_MAP,
+    PIPELINE_BP,
+    PIPELINE_PULSE,
+    PIPELINE_STAGES
+};
+
+// How often a stage was computed or found in the cache
+struct PIPELINE_STAGE_STATS {
+    unsigned long computed;
+    unsigned long memory_hits;
+    unsigned long disk_hits;
+};
+
+// 64 bit FNV-1a hash of the content a stage depends on
+class ContentHash {
+public:
+    ContentHash() : state(0xCBF29CE484222325ULL) {}
+
+    ContentHash &add(const void *data, size_t size) {
+        const unsigned char *bytes = (const unsigned char *)data;
+        for (size_t i = 0; i < size; i++){
+            state = (state ^ bytes[i]) * 0x100000001B3ULL;
+        }
+        return *this;
+    }
+
+    template <typename V>
+    ContentHash &add(const V &value) {
+        return add(&value, sizeof(value));
+    }
+
+    uint64_t value() const {
+        return state;
+    }
+
+private:
+    uint64_t state;
+};
+
+class AnalysisPipeline {
+public:
+    explicit AnalysisPipeline(const char *cache_directory = 0);   // Without a directory results are only cached in memory
+
+    SESSION_RESULT analyze(const SESSION &session, const MAA_PARAMETERS &parameters);
+    const PIPELINE_STAGE_STATS &stats(PIPELINE_STAGE stage) const { return stage_stats[stage]; }
+
+    static const char *stage_name(PIPELINE_STAGE stage);
+
+private:
+    struct MAP_RESULT {
+        sample_t map;
+        sample_t peak_amplitude;
+    };
+
+    template <typename V>
+    bool lookup(PIPELINE_STAGE stage, uint64_t key, std::unordered_map<uint64_t, V> &memory, V &value);
+    template <typename V>
+    void store(PIPELINE_STAGE stage, uint64_t key, std::unordered_map<uint64_t, V> &memory, const V &value);
+    std::string cache_path(PIPELINE_STAGE stage, uint64_t key) const;
+
+    std::string directory;
+    MeasurementSession<sample_t> measurement;
+    std::unordered_map<uint64_t, long> calibrations;
+    std::unordered_map<uint64_t, OMWE_ENVELOPE<sample_t> > envelopes;
+    std::unordered_map<uint64_t, MAP_RESULT> maps;
+    std::unordered_map<uint64_t, BP_PARAMETER> bps;
+    std::unordered_map<uint64_t, PULSE_READING> pulses;
+    PIPELINE_STAGE_STATS stage_stats[PIPELINE_STAGES];
+};
+
+int analyze(int argc, char **argv);
+
+#endif
@@ -0,0 +1,107 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       batch_analyzer.cpp
+* Description: Batch analysis of recorded sessions. Every session (load, calibration, normalization, OMWE extraction, MAP, systolic and
+* diastolic pressure, pulse) is one task of a WorkStealingPool, and every worker thread owns one MeasurementSession that it resets for
+* each of its tasks. The per session results are written as CSV in the order of the input files, the throughput to stderr.
+*/
+
+#include "batch_analyzer.h"
+#include <algorithm>
+#include <chrono>
+#include <dirent.h>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <thread>
+#include "session_analysis.h"
+#include "work_stealing_pool.h"
+
+// Outcome of one input file
+struct BATCH_ENTRY {
+    bool loaded;
+    SESSION_RESULT result;
+};
+
+bool collect_sessions(const char *path, std::vector<std::string> &files) {
+    struct stat info;
+    if (stat(path, &info) != 0){
+        fprintf(stderr, "Can not access %s\n", path);
+        return false;
+    }
+    if (!S_ISDIR(info.st_mode)){
+        files.push_back(path);
+        return true;
+    }
+    DIR *directory = opendir(path);
+    if (!directory){
+        fprintf(stderr, "Can not read directory %s\n", path);
+        return false;
+    }
+    std::vector<std::string> found;
+    while (struct dirent *item = readdir(directory)){
+        size_t length = strlen(item->d_name);
+        if (length > 4 && !strcmp(item->d_name + length - 4, ".bps")){
+            found.push_back(std::string(path) + "/" + item->d_name);
+        }
+    }
+    closedir(directory);
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+    return true;
+}
+
+int batch(int argc, char **argv) {
+    std::vector<std::string> files;
+    unsigned threads = std::thread::hardware_concurrency();
+    for (int i = 0; i < argc; i++){
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc){
+            threads = (unsigned)strtoul(argv[++i], 0, 10);
+        }
+        else if (!collect_sessions(argv[i], files)){
+            return 2;
+        }
+    }
+    if (files.empty()){
+        fprintf(stderr, "Usage: batch DIR_OR_FILE... [--threads N]\n");
+        return 2;
+    }
+
+    WorkStealingPool pool(threads);
+    std::vector<std::unique_ptr<MeasurementSession<sample_t> > > measurements;
+    for (unsigned worker = 0; worker < pool.threads(); worker++){
+        measurements.push_back(std::unique_ptr<MeasurementSession<sample_t> >(new MeasurementSession<sample_t>()));
+    }
+    std::vector<BATCH_ENTRY> entries(files.size());
+    std::chrono::steady_clock::time_point wall_start = std::chrono::steady_clock::now();
+    pool.run(files.size(), [&](unsigned worker, size_t index) {
+        SESSION session;
+        entries[index].loaded = session_load(files[index].c_str(), session) && session_rate_supported(files[index].c_str(), session);
+        if (entries[index].loaded){
+            entries[index].result = analyze_session(session, *measurements[worker]);
+        }
+    });
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    unsigned long analyzed = 0, complete = 0, samples = 0;
+    printf("file,samples,complete,systolic,diastolic,map,systolic_deviation,diastolic_deviation,pulse,pulse_intervals\n");
+    for (size_t i = 0; i < files.size(); i++){
+        if (!entries[i].loaded){
+            continue;
+        }
+        const SESSION_RESULT &result = entries[i].result;
+        printf("%s,%lu,%d,%.3f,%.3f,%.3f,%.4f,%.4f,%.3f,%ld\n", files[i].c_str(), result.samples, result.complete ? 1 : 0,
+               result.bp.systolic_bloodpressure, result.bp.diastolic_bloodpressure, result.mean_arterial_pressure,
+               result.bp.systolic_char_ratio, result.bp.diastolic_char_ratio, result.pulse.pulse_value, result.pulse.pulse_data_count);
+        analyzed++;
+        complete += result.complete ? 1 : 0;
+        samples += result.samples;
+    }
+    fprintf(stderr, "sessions = %lu analyzed (%lu complete, %lu unreadable or at another rate), samples = %lu\n", analyzed, complete,
+            (unsigned long)files.size() - analyzed, samples);
+    fprintf(stderr, "threads = %u, steals = %lu, wall time = %.3f s, %.1f sessions/s, %.0f samples/s\n", pool.threads(), pool.steals(),
+            wall_s, analyzed / wall_s, samples / wall_s);
+    return analyzed == files.size() ? 0 : 1;
+}
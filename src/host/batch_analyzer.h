@@ -0,0 +1,18 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       batch_analyzer.h
+* Description: Batch command of the host build: analyzes a corpus of recorded sessions on all cores.
+*
+* Usage: program batch DIR_OR_FILE... [--threads N] > results.csv
+*/
+
+#ifndef BATCH_ANALYZER_H
+#define BATCH_ANALYZER_H
+
+#include <string>
+#include <vector>
+
+bool collect_sessions(const char *path, std::vector<std::string> &files);   // A session file, or every *.bps file of a directory (sorted)
+int batch(int argc, char **argv);
+
+#endif
@@ -0,0 +1,307 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       host_main.cpp
+* Description: Entry point of the host build (pio run -e native). Runs the measurement algorithm and the MPR acquisition code of the firmware
+* against the simulated sensor and virtual clock of sim_hal.cpp, so a complete cuff deflation is processed in milliseconds.
+*
+* Usage: program [simulate] [--rate HZ] [waveform options]
+*        program generate [--rate HZ] [waveform options] > counts.csv
+*        program replay session.bps [--repeat N]
+*        program bench > bench.csv
+*        program batch DIR_OR_FILE... [--threads N] > results.csv
+*        program analyze DIR_OR_FILE... [--cache DIR] [--set NAME=VALUE]... > results.csv
+*        program sweep DIR_OR_FILE... --reference readings.csv [--vary NAME=LO:HI[:STEP]]... [--random N] [--seed S] [--threads N] > sweep.csv
+*
+* simulate only runs at the SAMPLE_RATE_HZ of the build, and replay, batch, analyze and sweep skip sessions recorded at another rate: the
+* filters and the OMWE decimation are designed for it. generate writes readings at any rate.
+*
+* simulate --record FILE saves the raw readings of the simulated measurement as a session image (see include/session_record.h), the same
+* format the target writes with SESSION_RECORDING, so simulated and field recordings can both be replayed.
+*
+* Waveform options (see waveform_generator.h): --inflate-at S --inflation MMHG_PER_S --peak MMHG --deflation MMHG_PER_S --sbp MMHG
+* --dbp MMHG --map MMHG --amplitude MMHG --envelope gaussian|triangular --hr BPM --hrv FRACTION --noise MMHG --artifacts PER_MIN
+* --artifact-amplitude MMHG --seed N
+*/
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "analysis_pipeline.h"
+#include "batch_analyzer.h"
+#include "benchmark.h"
+#include "bp_hal.h"
+#include "bp_monitor.h"
+#include "cycle_profile.h"
+#include "mpr_acquisition.h"
+#include "parameter_sweep.h"
+#include "session_analysis.h"
+#include "session_file.h"
+#include "sim_sensor.h"
+#include "waveform_generator.h"
+
+#define SIM_OVERRUN_US 5000000UL        // Simulations that do not detect the end of the measurement stop 5 s after the cuff is empty
+
+MeasurementSession<sample_t> measurement;       // Algorithm state of the simulate and replay commands
+std::vector<SESSION_ENTRY> recorded_entries;   // Session image of simulate --record
+
+// Sample recorder of simulate --record
+void record_sample(const PRESSURE_SAMPLE &sample) {
+    SESSION_ENTRY entry = {sample.timestamp_us, sample.pressure_data, (unsigned char)sample.status};
+    recorded_entries.push_back(entry);
+}
+
+// Printer of cycle_profile_print(), with CYCLE_PROFILING the stage timing is reported after the results
+void host_printf(const char *format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    vprintf(format, arguments);
+    va_end(arguments);
+}
+
+// Parses --rate and the waveform options into the defaults, prints an error and returns false on an unknown option
+// record_path receives --record, which is only accepted when it is given
+bool parse_options(int argc, char **argv, WAVEFORM_PARAMETERS &parameters, unsigned long &rate_hz, const char **record_path = 0) {
+    waveform_default_parameters(parameters);
+    rate_hz = SAMPLE_RATE_HZ;
+    for (int i = 0; i + 1 < argc; i += 2){
+        if (!strcmp(argv[i], "--rate")){
+            rate_hz = strtoul(argv[i + 1], 0, 10);
+        }
+        else if (record_path && !strcmp(argv[i], "--record")){
+            *record_path = argv[i + 1];
+        }
+        else if (!waveform_parse_option(parameters, argv[i], argv[i + 1])){
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return false;
+        }
+    }
+    if (argc % 2){
+        fprintf(stderr, "Missing value of option %s\n", argv[argc - 1]);
+        return false;
+    }
+    if (rate_hz == 0){
+        fprintf(stderr, "The sample rate must be positive\n");
+        return false;
+    }
+    return true;
+}
+
+/***Generate command*****
+Writes the raw sensor output of a synthetic waveform sampled at --rate as CSV (time, 24 bit count and the pressure before quantization),
+from 0 s until one second after the cuff is empty again. */
+
+int generate(int argc, char **argv) {
+    WAVEFORM_PARAMETERS parameters;
+    unsigned long rate_hz;
+    if (!parse_options(argc, argv, parameters, rate_hz)){
+        return 2;
+    }
+    WAVEFORM waveform;
+    waveform_init(waveform, parameters);
+    unsigned long end_us = (unsigned long)((waveform.end_s + 1.0) * 1e6);
+    printf("timestamp_us,raw_count,pressure\n");
+    for (unsigned long n = 0; n * 1000000ULL / rate_hz < end_us; n++){
+        unsigned long time_us = (unsigned long)(n * 1000000ULL / rate_hz);
+        printf("%lu,%ld,%.4f\n", time_us, waveform_counts(waveform, time_us), waveform_pressure(waveform, time_us));
+    }
+    return 0;
+}
+
+// Prints the results of the measurement that just ended, with the true values of a synthetic waveform if there is one
+void print_results(const MeasurementSession<sample_t> &measurement, const WAVEFORM_PARAMETERS *truth) {
+    BP_PARAMETER bp = measurement.Systolic_and_diastolic_bp_calculator();
+    PULSE_READING pulse = measurement.measure_pulse();
+    if (truth){
+        printf("MAP                = %.2f mmHg (true %.2f)\n", (double)measurement.mean_arterial_pressure(), truth->map);
+        printf("systolic pressure  = %.2f mmHg (true %.2f)\n", bp.systolic_bloodpressure, truth->systolic);
+        printf("diastolic pressure = %.2f mmHg (true %.2f)\n", bp.diastolic_bloodpressure, truth->diastolic);
+        printf("pulse              = %.2f bpm from %ld intervals (true %.2f)\n", pulse.pulse_value, pulse.pulse_data_count, truth->heart_rate);
+    }
+    else {
+        printf("MAP                = %.2f mmHg\n", (double)measurement.mean_arterial_pressure());
+        printf("systolic pressure  = %.2f mmHg\n", bp.systolic_bloodpressure);
+        printf("diastolic pressure = %.2f mmHg\n", bp.diastolic_bloodpressure);
+        printf("pulse              = %.2f bpm from %ld intervals\n", pulse.pulse_value, pulse.pulse_data_count);
+    }
+}
+
+int simulate(int argc, char **argv) {
+    WAVEFORM_PARAMETERS parameters;
+    unsigned long rate_hz;
+    const char *record_path = 0;
+    if (!parse_options(argc, argv, parameters, rate_hz, &record_path)){
+        return 2;
+    }
+    if (rate_hz != SAMPLE_RATE_HZ){
+        fprintf(stderr, "The filters are designed for %d Hz (SAMPLE_RATE_HZ), rebuild with -DSAMPLE_RATE_HZ=%lu to simulate at that rate\n",
+                SAMPLE_RATE_HZ, rate_hz);
+        return 2;
+    }
+    WAVEFORM waveform;
+    waveform_init(waveform, parameters);
+
+    std::chrono::steady_clock::time_point wall_start = std::chrono::steady_clock::now();
+    sim_reset();
+    sim_set_pressure_source(waveform_pressure_source, &waveform);
+    measurement.reset();
+    reset_acquisition();
+    cycle_profile_reset();
+    recorded_entries.clear();
+    set_sample_recorder(record_path ? record_sample : 0);
+    measurement.set_calibration(auto_caliberate());
+    unsigned long period_us = 1000000UL / rate_hz;
+    unsigned long next_tick_us = hal_now_us();
+    unsigned long next_gradient_check_us = next_tick_us + 1000000UL;
+    unsigned long sample_count = 0;
+    unsigned long time_limit_us = (unsigned long)(waveform.end_s * 1e6) + SIM_OVERRUN_US;
+    while (!measurement.complete() && hal_now_us() < time_limit_us) {
+        sim_advance_to(next_tick_us);
+        next_tick_us += period_us;
+#if MPR_PIPELINED
+        PRESSURE_SAMPLE sample = measure_pressure_pipelined();
+#else
+        PRESSURE_SAMPLE sample = measure_pressure();
+#endif
+        if (measurement.max_pressure_reached() && !measurement.recording()){      // The user presses the USER button when the red LED asks to release the pressure
+            SESSION_ENTRY event = {sample.timestamp_us, SESSION_EVENT_RECORD_START, SESSION_EVENT};
+            recorded_entries.push_back(event);
+            measurement.start_recording();
+        }
+        measurement.process_pressure_sample(sample);
+        sample_count++;
+        if (sample.timestamp_us >= next_gradient_check_us){
+            measurement.check_pressure_gradient();
+            next_gradient_check_us += 1000000UL;
+        }
+    }
+    set_sample_recorder(0);
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start).count();
+
+    printf("sample type        = %s\n", SampleTraits<sample_t>::name());
+    printf("simulated time     = %.3f s at %lu Hz (%lu samples, %lu conversions)\n", hal_now_us() / 1e6, rate_hz, sample_count, sim_conversion_count());
+    printf("wall time          = %.3f ms\n", wall_ms);
+    print_results(measurement, &parameters);
+#if CYCLE_PROFILING
+    cycle_profile_print(host_printf);
+    printf("\n");
+#endif
+    if (record_path && !session_save(record_path, rate_hz, recorded_entries)){
+        return 2;
+    }
+    return measurement.complete() ? 0 : 1;
+}
+
+/***Replay command*****
+Feeds the readings of a recorded session through the unchanged acquisition and algorithm code: the simulated sensor returns the recorded
+readings, auto_caliberate() averages the first CALIBRATION_SAMPLES of them, the USER button events are applied before the sample they were
+recorded with, and the pressure gradient is checked once per second of recorded time. Nothing waits for the real time, so with --repeat the
+same recording is measured N times in a row to time the algorithm. */
+
+int replay(int argc, char **argv) {
+    if (argc < 1){
+        fprintf(stderr, "Usage: replay session.bps [--repeat N]\n");
+        return 2;
+    }
+    unsigned long repeat = 1;
+    for (int i = 1; i + 1 < argc; i += 2){
+        if (!strcmp(argv[i], "--repeat")){
+            repeat = strtoul(argv[i + 1], 0, 10);
+        }
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    SESSION session;
+    if (!session_load(argv[0], session) || !session_rate_supported(argv[0], session)){
+        return 2;
+    }
+    if (session.samples.size() <= CALIBRATION_SAMPLES || repeat == 0){
+        fprintf(stderr, "Nothing to replay\n");
+        return 2;
+    }
+
+    cycle_profile_reset();
+    std::chrono::steady_clock::time_point wall_start = std::chrono::steady_clock::now();
+    for (unsigned long run = 0; run < repeat; run++){
+        sim_reset();
+        sim_replay(&session.samples[0], session.samples.size());
+        measurement.reset();
+        reset_acquisition();
+        measurement.set_calibration(auto_caliberate());
+        size_t event = 0;
+        unsigned long next_gradient_check_us = session.samples[CALIBRATION_SAMPLES].timestamp_us + 1000000UL;
+        while (!measurement.complete() && sim_replay_remaining() > 0) {
+            sim_advance_to(session.samples[session.samples.size() - sim_replay_remaining()].timestamp_us);
+            PRESSURE_SAMPLE sample = measure_pressure();
+            for (; event < session.events.size() && session.events[event].timestamp_us <= sample.timestamp_us; event++){
+                if (session.events[event].pressure_data == SESSION_EVENT_RECORD_START){
+                    measurement.start_recording();
+                }
+            }
+            measurement.process_pressure_sample(sample);
+            if (sample.timestamp_us >= next_gradient_check_us){
+                measurement.check_pressure_gradient();
+                next_gradient_check_us += 1000000UL;
+            }
+        }
+    }
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start).count();
+    sim_replay(0, 0);
+
+    double recorded_s = (session.samples.back().timestamp_us - session.samples.front().timestamp_us) / 1e6;
+    printf("sample type        = %s\n", SampleTraits<sample_t>::name());
+    printf("recording          = %.3f s at %u Hz (%lu readings, %lu events)\n", recorded_s, session.sample_rate_hz,
+           (unsigned long)session.samples.size(), (unsigned long)session.events.size());
+    printf("wall time          = %.3f ms for %lu runs (%.0f times real time)\n", wall_ms, repeat, recorded_s * repeat * 1000.0 / wall_ms);
+    print_results(measurement, 0);
+#if CYCLE_PROFILING
+    cycle_profile_print(host_printf);
+    printf("\n");
+#endif
+    return measurement.complete() ? 0 : 1;
+}
+
+/***Bench command*****
+Runs the pipeline benchmarks of benchmark.h and writes one CSV line per result, in the same format as the BENCHMARK_MODE firmware, so the
+output of two commits (or of the host and the target) can be compared with diff or a spreadsheet. */
+
+void print_bench_result(const BENCH_RESULT &result) {
+    printf("%s,%s,%lu,%lu,%.2f\n", result.stage, result.sample_type, result.size, result.calls, result.ticks_per_call);
+}
+
+int bench() {
+    printf("stage,sample_type,size,calls,%s_per_call\n", hal_bench_unit());
+    run_benchmarks(print_bench_result);
+    return 0;
+}
+
+// The unit tests (pio test -e native) build src/ with their own main()
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char **argv) {
+    if (argc > 1 && !strcmp(argv[1], "generate")){
+        return generate(argc - 2, argv + 2);
+    }
+    if (argc > 1 && !strcmp(argv[1], "batch")){
+        return batch(argc - 2, argv + 2);
+    }
+    if (argc > 1 && !strcmp(argv[1], "analyze")){
+        return analyze(argc - 2, argv + 2);
+    }
+    if (argc > 1 && !strcmp(argv[1], "sweep")){
+        return sweep(argc - 2, argv + 2);
+    }
+    if (argc > 1 && !strcmp(argv[1], "bench")){
+        return bench();
+    }
+    if (argc > 1 && !strcmp(argv[1], "replay")){
+        return replay(argc - 2, argv + 2);
+    }
+    if (argc > 1 && !strcmp(argv[1], "simulate")){
+        return simulate(argc - 2, argv + 2);
+    }
+    return simulate(argc - 1, argv + 1);
+}
+#endif
@@ -0,0 +1,351 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       parameter_sweep.cpp
+* Description: Parameter sweep over recorded sessions, see parameter_sweep.h. The sweep runs in two phases on a WorkStealingPool:
+*
+* 1. Extraction, one task per session: the session is analyzed with the widest OMWE thresholds of all parameter sets, keeping its OMWE
+*    graph and the (normalized pressure, oscillation amplitude) pair MAP_calculator() saw after every sample while recording.
+* 2. Evaluation, one task per parameter set: for every session the graph points inside the OMWE thresholds of the set are selected, the
+*    MAP amplitude is looked up in the stored pairs, and only maa_bp_calculator() is run.
+*
+* With OMWE_DECIMATION 1 (up to OMWE_MAX_POINT_RATE) a point is kept by the measurement depending only on its own normalized pressure, so
+* the filtered graph and the MAP are exactly what a full analysis with the parameter set would find. Above it the graph keeps the largest
+* peak of every OMWE_DECIMATION readings within the thresholds, and a narrower pair can keep another peak of a group that straddles one of
+* them; the sweep then extracts every distinct (omwe_min, omwe_max) pair of the sets on its own, which keeps the evaluation exact at the
+* cost of one extraction per pair. Only if an extracted graph filled the OMWE buffer, points the narrower thresholds would have kept may be
+* missing: those sessions stay loaded and are analyzed completely for every parameter set instead. OMWE_BUFFER_SIZE holds a release down
+* to MIN_RELEASE_RATE, so this only happens for slower releases or much wider thresholds; every such session is reported with a warning,
+* as it costs the speed of the sweep.
+*/
+
+#include "parameter_sweep.h"
+#include <chrono>
+#include <map>
+#include <math.h>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "batch_analyzer.h"
+#include "session_analysis.h"
+#include "work_stealing_pool.h"
+
+// One --vary option
+struct SWEEP_RANGE {
+    double MAA_PARAMETERS::*member;
+    double low;
+    double high;
+    double step;
+};
+
+// What the evaluation needs of one session
+struct SWEEP_SESSION {
+    bool usable;                       // Loaded, and a reference reading exists
+    double reference_systolic;
+    double reference_diastolic;
+    bool truncated;                    // One of the envelopes filled the OMWE buffer
+    std::vector<OMWE_ENVELOPE<sample_t> > envelopes;   // One per extraction, see sweep()
+    SESSION session;                   // Only kept if an envelope is truncated, the session is then analyzed completely for every set
+};
+
+// Error of one parameter set over the corpus, systolic/diastolic errors are estimate - reference
+struct SWEEP_SCORE {
+    unsigned long sessions;
+    unsigned long failures;            // Sessions for which no reliable systolic or diastolic pressure was found
+    double systolic_error;
+    double systolic_abs_error;
+    double diastolic_error;
+    double diastolic_abs_error;
+    double squared_error;
+};
+
+// Same generator as the waveform generator, so a seed gives the same parameter sets everywhere
+static double sweep_uniform(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return (z >> 11) * (1.0 / 9007199254740992.0);   // [0, 1)
+}
+
+static const char *base_name(const std::string &path) {
+    const char *slash = strrchr(path.c_str(), '/');
+    return slash ? slash + 1 : path.c_str();
+}
+
+static bool parse_range(const char *text, SWEEP_RANGE &range) {
+    const char *equals = strchr(text, '=');
+    if (!equals){
+        return false;
+    }
+    range.member = maa_parameter(text, equals - text);
+    range.step = 0.0;
+    int fields = sscanf(equals + 1, "%lf:%lf:%lf", &range.low, &range.high, &range.step);
+    return range.member && fields >= 2 && range.high >= range.low;
+}
+
+static bool load_references(const char *path, std::vector<std::string> &names, std::vector<double> &systolic, std::vector<double> &diastolic) {
+    FILE *file = fopen(path, "r");
+    if (!file){
+        fprintf(stderr, "Can not read %s\n", path);
+        return false;
+    }
+    char line[1024], name[512];
+    double sbp, dbp;
+    while (fgets(line, sizeof(line), file)){
+        if (sscanf(line, "%511[^,],%lf,%lf", name, &sbp, &dbp) == 3){     // The header line does not parse and is skipped
+            names.push_back(name);
+            systolic.push_back(sbp);
+            diastolic.push_back(dbp);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+// Every combination of the ranges, the last range varies fastest
+static void grid_sets(const std::vector<SWEEP_RANGE> &ranges, std::vector<MAA_PARAMETERS> &sets) {
+    MAA_PARAMETERS parameters = maa_default_parameters();
+    std::vector<long> index(ranges.size(), 0);
+    std::vector<long> steps(ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++){
+        steps[i] = ranges[i].step > 0.0 ? (long)floor((ranges[i].high - ranges[i].low) / ranges[i].step + 1e-9) + 1 : 1;
+    }
+    for (;;){
+        for (size_t i = 0; i < ranges.size(); i++){
+            parameters.*ranges[i].member = ranges[i].low + index[i] * ranges[i].step;
+        }
+        sets.push_back(parameters);
+        size_t digit = ranges.size();
+        while (digit > 0 && ++index[digit - 1] == steps[digit - 1]){
+            index[--digit] = 0;
+        }
+        if (digit == 0){
+            return;
+        }
+    }
+}
+
+// Final stage of the algorithm with one parameter set, on an extracted envelope. pressures/amplitudes are OMWE_BUFFER_SIZE scratch buffers.
+static BP_PARAMETER evaluate_envelope(const OMWE_ENVELOPE<sample_t> &envelope, const MAA_PARAMETERS &parameters, sample_t *pressures,
+                                      sample_t *amplitudes) {
+    sample_t peak;
+    sample_t map = envelope_map(envelope, parameters, peak);
+    long points = envelope_graph(envelope, parameters, pressures, amplitudes);
+    return maa_bp_calculator(pressures, amplitudes, points, peak, map, parameters);
+}
+
+int sweep(int argc, char **argv) {
+    std::vector<std::string> files;
+    std::vector<SWEEP_RANGE> ranges;
+    const char *reference_path = 0;
+    unsigned long random_sets = 0;
+    uint64_t seed = 1;
+    unsigned threads = std::thread::hardware_concurrency();
+    for (int i = 0; i < argc; i++){
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc){
+            threads = (unsigned)strtoul(argv[++i], 0, 10);
+        }
+        else if (!strcmp(argv[i], "--reference") && i + 1 < argc){
+            reference_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--random") && i + 1 < argc){
+            random_sets = strtoul(argv[++i], 0, 10);
+        }
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc){
+            seed = strtoull(argv[++i], 0, 10);
+        }
+        else if (!strcmp(argv[i], "--vary") && i + 1 < argc){
+            SWEEP_RANGE range;
+            if (!parse_range(argv[++i], range)){
+                fprintf(stderr, "Invalid range %s\n", argv[i]);
+                return 2;
+            }
+            ranges.push_back(range);
+        }
+        else if (!collect_sessions(argv[i], files)){
+            return 2;
+        }
+    }
+    if (files.empty() || !reference_path){
+        fprintf(stderr, "Usage: sweep DIR_OR_FILE... --reference readings.csv [--vary NAME=LO:HI[:STEP]]... [--random N] [--seed S] [--threads N]\n");
+        return 2;
+    }
+    std::vector<std::string> reference_names;
+    std::vector<double> reference_systolic, reference_diastolic;
+    if (!load_references(reference_path, reference_names, reference_systolic, reference_diastolic)){
+        return 2;
+    }
+
+    std::vector<MAA_PARAMETERS> sets(1, maa_default_parameters());
+    if (random_sets){
+        for (unsigned long set = 0; set < random_sets; set++){
+            MAA_PARAMETERS parameters = maa_default_parameters();
+            for (size_t i = 0; i < ranges.size(); i++){
+                parameters.*ranges[i].member = ranges[i].low + (ranges[i].high - ranges[i].low) * sweep_uniform(seed);
+            }
+            sets.push_back(parameters);
+        }
+    }
+    else if (!ranges.empty()){
+        grid_sets(ranges, sets);
+    }
+    for (size_t set = 0; set < sets.size(); set++){
+        if (!maa_parameters_valid<sample_t>(sets[set])){
+            fprintf(stderr, "envelope_bin_width %g is below the resolution of the sample type\n", sets[set].envelope_bin_width);
+            return 2;
+        }
+    }
+    // Without decimation one extraction keeps every point any of the sets can use, with it every threshold pair is extracted on its own
+    std::vector<MAA_PARAMETERS> extractions(1, maa_default_parameters());
+    std::vector<size_t> set_extraction(sets.size(), 0);
+    if (OMWE_DECIMATION == 1){
+        for (size_t set = 0; set < sets.size(); set++){
+            extractions[0].min_omwe_thresh = fmin(extractions[0].min_omwe_thresh, sets[set].min_omwe_thresh);
+            extractions[0].max_omwe_thresh = fmax(extractions[0].max_omwe_thresh, sets[set].max_omwe_thresh);
+        }
+    }
+    else {
+        std::map<std::pair<double, double>, size_t> pairs;
+        extractions.clear();
+        for (size_t set = 0; set < sets.size(); set++){
+            std::pair<double, double> pair(sets[set].min_omwe_thresh, sets[set].max_omwe_thresh);
+            std::map<std::pair<double, double>, size_t>::iterator found = pairs.find(pair);
+            if (found == pairs.end()){
+                found = pairs.insert(std::make_pair(pair, extractions.size())).first;
+                extractions.push_back(maa_default_parameters());
+                extractions.back().min_omwe_thresh = pair.first;
+                extractions.back().max_omwe_thresh = pair.second;
+            }
+            set_extraction[set] = found->second;
+        }
+    }
+
+    WorkStealingPool pool(threads);
+    std::vector<std::unique_ptr<MeasurementSession<sample_t> > > measurements;
+    for (unsigned worker = 0; worker < pool.threads(); worker++){
+        measurements.push_back(std::unique_ptr<MeasurementSession<sample_t> >(new MeasurementSession<sample_t>()));
+    }
+    std::vector<SWEEP_SESSION> sessions(files.size());
+    std::chrono::steady_clock::time_point extraction_start = std::chrono::steady_clock::now();
+    pool.run(files.size(), [&](unsigned worker, size_t index) {
+        SWEEP_SESSION &entry = sessions[index];
+        entry.usable = false;
+        entry.truncated = false;
+        for (size_t i = 0; i < reference_names.size(); i++){
+            if (reference_names[i] == base_name(files[index])){
+                entry.reference_systolic = reference_systolic[i];
+                entry.reference_diastolic = reference_diastolic[i];
+                entry.usable = true;
+            }
+        }
+        if (entry.usable && session_load(files[index].c_str(), entry.session) && session_rate_supported(files[index].c_str(), entry.session)){
+            long zero_output = session_calibration(entry.session);
+            entry.envelopes.resize(extractions.size());
+            for (size_t extraction = 0; extraction < extractions.size(); extraction++){
+                measurements[worker]->set_parameters(extractions[extraction]);
+                extract_envelope(entry.session, zero_output, *measurements[worker], entry.envelopes[extraction]);
+                entry.truncated = entry.truncated || entry.envelopes[extraction].truncated;
+            }
+        }
+        else {
+            entry.usable = false;
+        }
+        if (!entry.truncated){
+            entry.session = SESSION();
+        }
+    });
+    double extraction_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - extraction_start).count();
+    for (size_t i = 0; i < sessions.size(); i++){
+        if (sessions[i].usable && sessions[i].truncated){
+            fprintf(stderr, "WARNING: %s filled the OMWE buffer (%ld points) with the extracted thresholds, its envelope can not be reused and "
+                    "it is analyzed completely for every set\n", files[i].c_str(), (long)OMWE_BUFFER_SIZE);
+        }
+    }
+
+    std::vector<std::vector<sample_t> > scratch(pool.threads(), std::vector<sample_t>(2 * OMWE_BUFFER_SIZE));
+    std::vector<SWEEP_SCORE> scores(sets.size());
+    std::chrono::steady_clock::time_point evaluation_start = std::chrono::steady_clock::now();
+    pool.run(sets.size(), [&](unsigned worker, size_t index) {
+        SWEEP_SCORE score = {0, 0, 0.0, 0.0, 0.0, 0.0, 0.0};
+        for (size_t i = 0; i < sessions.size(); i++){
+            if (!sessions[i].usable){
+                continue;
+            }
+            BP_PARAMETER bp;
+            if (sessions[i].truncated){
+                measurements[worker]->set_parameters(sets[index]);
+                bp = analyze_session(sessions[i].session, *measurements[worker]).bp;
+            }
+            else {
+                bp = evaluate_envelope(sessions[i].envelopes[set_extraction[index]], sets[index], &scratch[worker][0],
+                                       &scratch[worker][OMWE_BUFFER_SIZE]);
+            }
+            score.sessions++;
+            if (bp.systolic_bloodpressure < 0 || bp.diastolic_bloodpressure < 0){
+                score.failures++;
+                continue;
+            }
+            double systolic_error = bp.systolic_bloodpressure - sessions[i].reference_systolic;
+            double diastolic_error = bp.diastolic_bloodpressure - sessions[i].reference_diastolic;
+            score.systolic_error += systolic_error;
+            score.systolic_abs_error += fabs(systolic_error);
+            score.diastolic_error += diastolic_error;
+            score.diastolic_abs_error += fabs(diastolic_error);
+            score.squared_error += systolic_error * systolic_error + diastolic_error * diastolic_error;
+        }
+        scores[index] = score;
+    });
+    double evaluation_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - evaluation_start).count();
+
+    size_t best = 0;
+    double best_rms = 0.0;
+    printf("set");
+    for (size_t i = 0; i < maa_parameter_count; i++){
+        printf(",%s", maa_parameter_names[i].name);
+    }
+    printf(",sessions,failures,systolic_mae,systolic_bias,diastolic_mae,diastolic_bias,rms_error\n");
+    for (size_t set = 0; set < sets.size(); set++){
+        const SWEEP_SCORE &score = scores[set];
+        double measured = (double)(score.sessions - score.failures);
+        double rms = measured > 0 ? sqrt(score.squared_error / (2.0 * measured)) : -1.0;
+        printf("%lu", (unsigned long)set);
+        for (size_t i = 0; i < maa_parameter_count; i++){
+            printf(",%.4f", sets[set].*maa_parameter_names[i].member);
+        }
+        printf(",%lu,%lu,%.3f,%.3f,%.3f,%.3f,%.3f\n", score.sessions, score.failures, measured > 0 ? score.systolic_abs_error / measured : -1.0,
+               measured > 0 ? score.systolic_error / measured : 0.0, measured > 0 ? score.diastolic_abs_error / measured : -1.0,
+               measured > 0 ? score.diastolic_error / measured : 0.0, rms);
+        // Best set: fewest failures, then lowest RMS error
+        if (rms >= 0 && (set == 0 || score.failures < scores[best].failures || (score.failures == scores[best].failures && rms < best_rms))){
+            best = set;
+            best_rms = rms;
+        }
+    }
+
+    unsigned long usable = 0, truncated = 0;
+    for (size_t i = 0; i < sessions.size(); i++){
+        usable += sessions[i].usable ? 1 : 0;
+        truncated += sessions[i].usable && sessions[i].truncated ? 1 : 0;
+    }
+    fprintf(stderr, "sessions = %lu evaluated (%lu without reference, unreadable or at another rate), parameter sets = %lu\n", usable,
+            (unsigned long)files.size() - usable, (unsigned long)sets.size());
+    if (OMWE_DECIMATION > 1){
+        fprintf(stderr, "OMWE_DECIMATION = %d: the graph depends on the OMWE thresholds, %lu threshold pairs were extracted per session\n",
+                (int)OMWE_DECIMATION, (unsigned long)extractions.size());
+    }
+    if (truncated){
+        fprintf(stderr, "WARNING: %lu of %lu sessions filled the OMWE buffer and were analyzed completely for every set (release slower than "
+                "MIN_RELEASE_RATE or OMWE thresholds wider than the defaults?)\n", truncated, usable);
+    }
+    fprintf(stderr, "threads = %u, extraction = %.3f s, evaluation = %.3f s (%.0f set evaluations/s)\n", pool.threads(), extraction_s,
+            evaluation_s, sets.size() * (double)usable / evaluation_s);
+    fprintf(stderr, "best set = %lu, %lu failures, rms error = %.3f mmHg (bp_config.h: %lu failures, rms error = %.3f mmHg)\n",
+            (unsigned long)best, scores[best].failures, best_rms, scores[0].failures,
+            scores[0].sessions > scores[0].failures ? sqrt(scores[0].squared_error / (2.0 * (scores[0].sessions - scores[0].failures))) : -1.0);
+    return usable ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       parameter_sweep.h
+* Description: Sweep command of the host build: evaluates grids or random samples of the MAA parameters (MAA_PARAMETERS in bp_monitor.h)
+* over a corpus of recorded sessions and reports the error of every parameter set against reference readings.
+*
+* Usage: program sweep DIR_OR_FILE... --reference readings.csv [--vary NAME=LO:HI[:STEP]]... [--random N] [--seed S] [--threads N]
+*        > sweep.csv
+*
+* readings.csv has lines "file,systolic,diastolic", file is matched against the name of the session file without its directory.
+* Without --random every --vary parameter runs from LO to HI in steps of STEP and all combinations are evaluated, with --random N each of
+* the N sets draws every --vary parameter uniformly from LO .. HI. Parameters that are not varied keep their bp_config.h value, and the
+* first row always is the bp_config.h parameter set. NAME is one of rs_lower, rs_upper, rd_lower, rd_upper, omwe_min, omwe_max, map_max,
+* map_error, systolic_min, systolic_max, diastolic_min, diastolic_max, bin_width.
+*/
+
+#ifndef PARAMETER_SWEEP_H
+#define PARAMETER_SWEEP_H
+
+int sweep(int argc, char **argv);
+
+#endif
@@ -0,0 +1,174 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       session_analysis.cpp
+* Description: Analysis of recorded sessions without the hardware abstraction, see session_analysis.h.
+*/
+
+#include "session_analysis.h"
+#include <stdio.h>
+#include <string.h>
+
+const MAA_PARAMETER_NAME maa_parameter_names[] = {
+    {"rs_lower", &MAA_PARAMETERS::systolic_lower_ratio},
+    {"rs_upper", &MAA_PARAMETERS::systolic_upper_ratio},
+    {"rd_lower", &MAA_PARAMETERS::diastolic_lower_ratio},
+    {"rd_upper", &MAA_PARAMETERS::diastolic_upper_ratio},
+    {"omwe_min", &MAA_PARAMETERS::min_omwe_thresh},
+    {"omwe_max", &MAA_PARAMETERS::max_omwe_thresh},
+    {"map_max", &MAA_PARAMETERS::map_search_max},
+    {"map_error", &MAA_PARAMETERS::map_error_thresh},
+    {"systolic_min", &MAA_PARAMETERS::systolic_search_min},
+    {"systolic_max", &MAA_PARAMETERS::systolic_search_max},
+    {"diastolic_min", &MAA_PARAMETERS::diastolic_search_min},
+    {"diastolic_max", &MAA_PARAMETERS::diastolic_search_max},
+    {"bin_width", &MAA_PARAMETERS::envelope_bin_width},
+};
+const size_t maa_parameter_count = sizeof(maa_parameter_names) / sizeof(maa_parameter_names[0]);
+
+double MAA_PARAMETERS::*maa_parameter(const char *name, size_t length) {
+    for (size_t i = 0; i < maa_parameter_count; i++){
+        if (strlen(maa_parameter_names[i].name) == length && !strncmp(name, maa_parameter_names[i].name, length)){
+            return maa_parameter_names[i].member;
+        }
+    }
+    return 0;
+}
+
+bool session_rate_supported(const char *path, const SESSION &session) {
+    if (session.sample_rate_hz != SAMPLE_RATE_HZ){
+        fprintf(stderr, "%s is recorded at %u Hz, this build analyzes %d Hz sessions (SAMPLE_RATE_HZ)\n", path, session.sample_rate_hz,
+                SAMPLE_RATE_HZ);
+        return false;
+    }
+    return true;
+}
+
+long session_calibration(const SESSION &session) {
+    unsigned long default_pressure = 0;
+    if (session.samples.size() < CALIBRATION_SAMPLES){
+        return 0;
+    }
+    for (int i = 0; i < CALIBRATION_SAMPLES; i++){
+        default_pressure += session.samples[i].pressure_data;
+    }
+    return default_pressure / CALIBRATION_SAMPLES;
+}
+
+// Without an observer the readings go through process_pressure_block(). A block ends before a reading that has a USER button event and
+// after one that is followed by a gradient check, so the results are the same as with one reading at a time.
+template <typename T>
+SESSION_RESULT analyze_session(const SESSION &session, MeasurementSession<T> &measurement) {
+    SESSION_RESULT result;
+    PRESSURE_SAMPLE block[PROCESS_BLOCK_SIZE];
+    long block_samples = 0;
+    measurement.reset();
+    measurement.set_calibration(session_calibration(session));
+    result.samples = 0;
+    if (session.samples.size() > CALIBRATION_SAMPLES){
+        size_t event = 0;
+        unsigned long next_gradient_check_us = session.samples[CALIBRATION_SAMPLES].timestamp_us + 1000000UL;
+        for (size_t i = CALIBRATION_SAMPLES; i < session.samples.size() && !measurement.complete(); i++){
+            const SESSION_ENTRY &entry = session.samples[i];
+            PRESSURE_SAMPLE sample = {entry.timestamp_us, 0, entry.pressure_data, (char)entry.status};
+            if (event < session.events.size() && session.events[event].timestamp_us <= sample.timestamp_us){
+                result.samples += measurement.process_pressure_block(block, block_samples);
+                block_samples = 0;
+                for (; event < session.events.size() && session.events[event].timestamp_us <= sample.timestamp_us; event++){
+                    if (session.events[event].pressure_data == SESSION_EVENT_RECORD_START){
+                        measurement.start_recording();
+                    }
+                }
+            }
+            block[block_samples++] = sample;
+            bool gradient_check = sample.timestamp_us >= next_gradient_check_us;
+            if (block_samples == PROCESS_BLOCK_SIZE || gradient_check){
+                long processed = measurement.process_pressure_block(block, block_samples);
+                result.samples += processed;
+                gradient_check = gradient_check && processed == block_samples;     // Not if the measurement ended before that reading
+                block_samples = 0;
+            }
+            if (gradient_check){
+                measurement.check_pressure_gradient();
+                next_gradient_check_us += 1000000UL;
+            }
+        }
+        result.samples += measurement.process_pressure_block(block, block_samples);
+    }
+    result.complete = measurement.complete();
+    result.bp = measurement.Systolic_and_diastolic_bp_calculator();
+    result.pulse = measurement.measure_pulse();
+    result.mean_arterial_pressure = (double)measurement.mean_arterial_pressure();
+    return result;
+}
+
+template <typename T>
+void extract_envelope(const SESSION &session, long zero_output, MeasurementSession<T> &measurement, OMWE_ENVELOPE<T> &envelope) {
+    envelope.track_pressures.clear();
+    envelope.track_amplitudes.clear();
+    SESSION_RESULT result = analyze_session(session, zero_output, measurement, [&envelope](const MeasurementSession<T> &state) {
+        if (state.recording() && state.pressure_difference() > T(0)){      // MAP_calculator() can not take a zero amplitude
+            envelope.track_pressures.push_back(state.normalized_pressure());
+            envelope.track_amplitudes.push_back(state.pressure_difference());
+        }
+    });
+    long points = measurement.omwe_points();
+    envelope.samples = result.samples;
+    envelope.complete = result.complete;
+    envelope.truncated = points == OMWE_BUFFER_SIZE;
+    envelope.pressures.resize(points);
+    envelope.amplitudes.resize(points);
+    for (long i = 0; i < points; i++){
+        envelope.pressures[i] = measurement.omwe_pressure(i);
+        envelope.amplitudes[i] = measurement.omwe_amplitude(i);
+    }
+    envelope.peak_times_ms.resize(measurement.omwe_time_points());
+    envelope.peak_amplitudes.resize(measurement.omwe_time_points());
+    for (long i = 0; i < measurement.omwe_time_points(); i++){
+        envelope.peak_times_ms[i] = measurement.omwe_time(i);
+        envelope.peak_amplitudes[i] = measurement.omwe_beat_amplitude(i);
+    }
+}
+
+template <typename T>
+T envelope_map(const OMWE_ENVELOPE<T> &envelope, const MAA_PARAMETERS &parameters, T &peak_amplitude) {
+    const T min_omwe(parameters.min_omwe_thresh), map_max(parameters.map_search_max);
+    T map(0);
+    peak_amplitude = T(0);
+    for (size_t i = 0; i < envelope.track_pressures.size(); i++){
+        if (envelope.track_amplitudes[i] > peak_amplitude && envelope.track_pressures[i] > min_omwe && envelope.track_pressures[i] < map_max){
+            peak_amplitude = envelope.track_amplitudes[i];
+            map = envelope.track_pressures[i];
+        }
+    }
+    return map;
+}
+
+template <typename T>
+long envelope_graph(const OMWE_ENVELOPE<T> &envelope, const MAA_PARAMETERS &parameters, T *pressures, T *amplitudes) {
+    const T min_omwe(parameters.min_omwe_thresh), max_omwe(parameters.max_omwe_thresh);
+    long points = 0;
+    for (size_t i = 0; i < envelope.pressures.size() && points < OMWE_BUFFER_SIZE; i++){
+        if (envelope.pressures[i] > min_omwe && envelope.pressures[i] < max_omwe){
+            pressures[points] = envelope.pressures[i];
+            amplitudes[points++] = envelope.amplitudes[i];
+        }
+    }
+    return points;
+}
+
+template SESSION_RESULT analyze_session(const SESSION &session, MeasurementSession<double> &measurement);
+template SESSION_RESULT analyze_session(const SESSION &session, MeasurementSession<float> &measurement);
+template SESSION_RESULT analyze_session(const SESSION &session, MeasurementSession<q16_16_t> &measurement);
+template SESSION_RESULT analyze_session(const SESSION &session, MeasurementSession<count_t> &measurement);
+template void extract_envelope(const SESSION &session, long zero_output, MeasurementSession<double> &measurement, OMWE_ENVELOPE<double> &envelope);
+template void extract_envelope(const SESSION &session, long zero_output, MeasurementSession<float> &measurement, OMWE_ENVELOPE<float> &envelope);
+template void extract_envelope(const SESSION &session, long zero_output, MeasurementSession<q16_16_t> &measurement, OMWE_ENVELOPE<q16_16_t> &envelope);
+template void extract_envelope(const SESSION &session, long zero_output, MeasurementSession<count_t> &measurement, OMWE_ENVELOPE<count_t> &envelope);
+template double envelope_map(const OMWE_ENVELOPE<double> &envelope, const MAA_PARAMETERS &parameters, double &peak_amplitude);
+template float envelope_map(const OMWE_ENVELOPE<float> &envelope, const MAA_PARAMETERS &parameters, float &peak_amplitude);
+template q16_16_t envelope_map(const OMWE_ENVELOPE<q16_16_t> &envelope, const MAA_PARAMETERS &parameters, q16_16_t &peak_amplitude);
+template count_t envelope_map(const OMWE_ENVELOPE<count_t> &envelope, const MAA_PARAMETERS &parameters, count_t &peak_amplitude);
+template long envelope_graph(const OMWE_ENVELOPE<double> &envelope, const MAA_PARAMETERS &parameters, double *pressures, double *amplitudes);
+template long envelope_graph(const OMWE_ENVELOPE<float> &envelope, const MAA_PARAMETERS &parameters, float *pressures, float *amplitudes);
+template long envelope_graph(const OMWE_ENVELOPE<q16_16_t> &envelope, const MAA_PARAMETERS &parameters, q16_16_t *pressures, q16_16_t *amplitudes);
+template long envelope_graph(const OMWE_ENVELOPE<count_t> &envelope, const MAA_PARAMETERS &parameters, count_t *pressures, count_t *amplitudes);
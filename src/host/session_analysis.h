@@ -0,0 +1,115 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       session_analysis.h
+* Description: Runs the complete measurement algorithm on a recorded session without the hardware abstraction: the calibration averages the
+* first CALIBRATION_SAMPLES readings like auto_caliberate(), the USER button events start the OMWE recording before the sample they were
+* recorded with, and the pressure gradient is checked once per second of recorded time, exactly as the replay command does. Nothing here
+* touches global state, so any number of sessions can be analyzed concurrently, each with its own MeasurementSession.
+* (Built with CYCLE_PROFILING the stage statistics are global and only meaningful for one thread.)
+*/
+
+#ifndef SESSION_ANALYSIS_H
+#define SESSION_ANALYSIS_H
+
+#include <stddef.h>
+#include <vector>
+#include "bp_monitor.h"
+#include "session_file.h"
+
+// Outcome of one analyzed session
+struct SESSION_RESULT {
+    unsigned long samples;          // Readings processed after the calibration
+    bool complete;                  // The end of the measurement was detected
+    BP_PARAMETER bp;
+    PULSE_READING pulse;
+    double mean_arterial_pressure;
+};
+
+// Intermediate result of a session that only depends on its readings, the calibration and the OMWE thresholds: the OMWE graph, the OMWE
+// time buffer and the (normalized pressure, oscillation amplitude) pair MAP_calculator() saw after every sample while recording. The MAP,
+// systolic/diastolic and pulse stages can be re-run on it without processing the readings again.
+template <typename T>
+struct OMWE_ENVELOPE {
+    unsigned long samples;                 // Readings processed after the calibration
+    bool complete;
+    bool truncated;                        // The graph filled the OMWE buffer
+    std::vector<T> pressures;              // OMWE graph x values
+    std::vector<T> amplitudes;             // OMWE graph y values
+    std::vector<unsigned long> peak_times_ms;    // Heart beats and their oscillation maxima (OMWE time buffer)
+    std::vector<T> peak_amplitudes;
+    std::vector<T> track_pressures;
+    std::vector<T> track_amplitudes;
+};
+
+// Command line names of the MAA_PARAMETERS members (rs_lower, rs_upper, rd_lower, rd_upper, omwe_min, omwe_max, map_max, map_error,
+// systolic_min, systolic_max, diastolic_min, diastolic_max, bin_width)
+struct MAA_PARAMETER_NAME {
+    const char *name;
+    double MAA_PARAMETERS::*member;
+};
+
+extern const MAA_PARAMETER_NAME maa_parameter_names[];
+extern const size_t maa_parameter_count;
+
+double MAA_PARAMETERS::*maa_parameter(const char *name, size_t length);   // 0 if there is no parameter of that name
+long session_calibration(const SESSION &session);    // Zero reference from the calibration readings, as auto_caliberate() computes it
+
+// The filters, the moving averages and the OMWE decimation count readings of SAMPLE_RATE_HZ, so a session recorded at another rate would be
+// analyzed with the wrong cutoffs: prints an error naming path and returns false for it (rebuild with -DSAMPLE_RATE_HZ to analyze it)
+bool session_rate_supported(const char *path, const SESSION &session);
+
+// Runs the recorded readings through measurement in blocks of PROCESS_BLOCK_SIZE, like the processing loop of the target
+template <typename T>
+SESSION_RESULT analyze_session(const SESSION &session, MeasurementSession<T> &measurement);
+
+// Analyzes the session with the parameters of measurement and keeps the envelope
+template <typename T>
+void extract_envelope(const SESSION &session, long zero_output, MeasurementSession<T> &measurement, OMWE_ENVELOPE<T> &envelope);
+
+// MAP stage on an envelope: returns the MAP and its amplitude as MAP_calculator() finds them with the thresholds of parameters
+template <typename T>
+T envelope_map(const OMWE_ENVELOPE<T> &envelope, const MAA_PARAMETERS &parameters, T &peak_amplitude);
+
+// The points of the graph within the OMWE thresholds of parameters (at most OMWE_BUFFER_SIZE), returns their number. Both are exact for
+// thresholds within the ones of the extraction, as long as the extracted graph did not fill the buffer. With OMWE_DECIMATION > 1 the graph
+// keeps the largest peak of every OMWE_DECIMATION readings within the thresholds, so the graph is only exact for the thresholds it was
+// extracted with.
+template <typename T>
+long envelope_graph(const OMWE_ENVELOPE<T> &envelope, const MAA_PARAMETERS &parameters, T *pressures, T *amplitudes);
+
+// Same as above with a given zero reference, calling observer(measurement) after every processed sample, e.g. to capture intermediate
+// state of the algorithm
+template <typename T, typename Observer>
+SESSION_RESULT analyze_session(const SESSION &session, long zero_output, MeasurementSession<T> &measurement, Observer observer) {
+    SESSION_RESULT result;
+    measurement.reset();
+    measurement.set_calibration(zero_output);
+    result.samples = 0;
+    if (session.samples.size() > CALIBRATION_SAMPLES){
+        size_t event = 0;
+        unsigned long next_gradient_check_us = session.samples[CALIBRATION_SAMPLES].timestamp_us + 1000000UL;
+        for (size_t i = CALIBRATION_SAMPLES; i < session.samples.size() && !measurement.complete(); i++){
+            const SESSION_ENTRY &entry = session.samples[i];
+            PRESSURE_SAMPLE sample = {entry.timestamp_us, 0, entry.pressure_data, (char)entry.status};
+            for (; event < session.events.size() && session.events[event].timestamp_us <= sample.timestamp_us; event++){
+                if (session.events[event].pressure_data == SESSION_EVENT_RECORD_START){
+                    measurement.start_recording();
+                }
+            }
+            measurement.process_pressure_sample(sample);
+            if (sample.timestamp_us >= next_gradient_check_us){
+                measurement.check_pressure_gradient();
+                next_gradient_check_us += 1000000UL;
+            }
+            observer(measurement);
+            result.samples++;
+        }
+    }
+    result.complete = measurement.complete();
+    result.bp = measurement.Systolic_and_diastolic_bp_calculator();
+    result.pulse = measurement.measure_pulse();
+    result.mean_arterial_pressure = (double)measurement.mean_arterial_pressure();
+    return result;
+}
+
+#endif
@@ -0,0 +1,57 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       session_file.cpp
+* Description: Session image files of the host build, see session_file.h.
+*/
+
+#include "session_file.h"
+#include <stdio.h>
+
+bool session_load(const char *path, SESSION &session) {
+    FILE *file = fopen(path, "rb");
+    if (!file){
+        fprintf(stderr, "Can not open %s\n", path);
+        return false;
+    }
+    uint8_t buffer[SESSION_HEADER_SIZE];
+    uint16_t sample_rate_hz;
+    if (fread(buffer, 1, SESSION_HEADER_SIZE, file) != SESSION_HEADER_SIZE || !session_get_header(buffer, sample_rate_hz)){
+        fprintf(stderr, "%s is not a session image\n", path);
+        fclose(file);
+        return false;
+    }
+    session.sample_rate_hz = sample_rate_hz;
+    session.samples.clear();
+    session.events.clear();
+    while (fread(buffer, 1, SESSION_ENTRY_SIZE, file) == SESSION_ENTRY_SIZE){
+        SESSION_ENTRY entry = session_get_entry(buffer);
+        if (entry.status & SESSION_EVENT){
+            session.events.push_back(entry);
+        }
+        else {
+            session.samples.push_back(entry);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+bool session_save(const char *path, unsigned sample_rate_hz, const std::vector<SESSION_ENTRY> &entries) {
+    FILE *file = fopen(path, "wb");
+    if (!file){
+        fprintf(stderr, "Can not create %s\n", path);
+        return false;
+    }
+    uint8_t buffer[SESSION_HEADER_SIZE];
+    session_put_header(buffer, (uint16_t)sample_rate_hz);
+    bool written = fwrite(buffer, 1, SESSION_HEADER_SIZE, file) == SESSION_HEADER_SIZE;
+    for (size_t i = 0; written && i < entries.size(); i++){
+        session_put_entry(buffer, entries[i]);
+        written = fwrite(buffer, 1, SESSION_ENTRY_SIZE, file) == SESSION_ENTRY_SIZE;
+    }
+    if (fclose(file) != 0 || !written){
+        fprintf(stderr, "Error writing %s\n", path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,23 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       session_file.h
+* Description: Reading and writing session images (see include/session_record.h) as files on the host.
+*/
+
+#ifndef SESSION_FILE_H
+#define SESSION_FILE_H
+
+#include <vector>
+#include "session_record.h"
+
+// A loaded session, with the sensor readings and the events separated
+struct SESSION {
+    unsigned sample_rate_hz;
+    std::vector<SESSION_ENTRY> samples;
+    std::vector<SESSION_ENTRY> events;
+};
+
+bool session_load(const char *path, SESSION &session);         // Prints the reason and returns false if the file is not a valid image
+bool session_save(const char *path, unsigned sample_rate_hz, const std::vector<SESSION_ENTRY> &entries);
+
+#endif
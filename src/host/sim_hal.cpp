@@ -0,0 +1,143 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       sim_hal.cpp
+* Description: Host implementation of the hardware abstraction (bp_hal.h) with a simulated MPR sensor and a virtual clock (see sim_sensor.h).
+*/
+
+#include <chrono>
+#include "bp_config.h"
+#include "bp_hal.h"
+#include "sim_sensor.h"
+
+unsigned long sim_time_us = 0;               // Virtual clock
+SIM_PRESSURE_SOURCE sim_pressure_source = 0;
+void *sim_pressure_context = 0;
+bool sim_converting = false;
+unsigned long sim_conversion_start_us = 0;
+long sim_output = OUTPUT_MIN;               // Output register of the simulated sensor
+unsigned long sim_conversions = 0;
+const SESSION_ENTRY *sim_replay_samples = 0;   // Recorded readings returned instead of the simulated conversions
+size_t sim_replay_count = 0;
+size_t sim_replay_index = 0;
+
+void sim_reset() {
+    sim_time_us = 0;
+    sim_converting = false;
+    sim_output = OUTPUT_MIN;
+    sim_conversions = 0;
+    sim_replay_index = 0;
+}
+
+void sim_set_pressure_source(SIM_PRESSURE_SOURCE source, void *context) {
+    sim_pressure_source = source;
+    sim_pressure_context = context;
+}
+
+void sim_advance_to(unsigned long time_us) {
+    if (time_us > sim_time_us){
+        sim_time_us = time_us;
+    }
+}
+
+unsigned long sim_conversion_count() {
+    return sim_conversions;
+}
+
+long sim_pressure_to_output(double pressure) {
+    double output = OUTPUT_MIN + (pressure - PRESSURE_MIN) * (OUTPUT_MAX - OUTPUT_MIN) / (PRESSURE_MAX - PRESSURE_MIN);
+    if (output < 0){
+        output = 0;
+    }
+    if (output > 0xFFFFFF){
+        output = 0xFFFFFF;
+    }
+    return (long)(output + 0.5);
+}
+
+void sim_replay(const SESSION_ENTRY *samples, size_t count) {
+    sim_replay_samples = samples;
+    sim_replay_count = samples ? count : 0;
+    sim_replay_index = 0;
+}
+
+size_t sim_replay_remaining() {
+    return sim_replay_count - sim_replay_index;
+}
+
+// Answers a read command with the next recorded reading. Status polls always find the recorded conversion finished.
+void sim_replay_read(char *response, int length) {
+    if (length < 4){
+        response[0] = (char)MPR_STATUS_POWERED;
+        return;
+    }
+    if (sim_replay_index < sim_replay_count){
+        const SESSION_ENTRY &entry = sim_replay_samples[sim_replay_index++];
+        response[0] = (char)entry.status;
+        response[1] = (char)(entry.pressure_data >> 16);
+        response[2] = (char)(entry.pressure_data >> 8);
+        response[3] = (char)entry.pressure_data;
+    }
+}
+
+// Finishes the running conversion once its conversion time has passed on the virtual clock
+void sim_update_conversion() {
+    if (sim_converting && sim_time_us - sim_conversion_start_us >= SIM_CONVERSION_US){
+        double pressure = sim_pressure_source ? sim_pressure_source(sim_conversion_start_us, sim_pressure_context) : 0.0;
+        sim_output = sim_pressure_to_output(pressure);
+        sim_converting = false;
+    }
+}
+
+bool mpr_spi_exchange(const char *command, char *response, int length) {
+    sim_update_conversion();
+    for (int i = 0; i < length; i++){
+        response[i] = 0;
+    }
+    if (sim_replay_samples){
+        if ((unsigned char)command[0] == MPR_CMD_READ){
+            sim_replay_read(response, length);
+        }
+        return true;
+    }
+    if ((unsigned char)command[0] == MPR_CMD_START_CONVERSION){
+        sim_converting = true;
+        sim_conversion_start_us = sim_time_us;
+        sim_conversions++;
+    }
+    else if ((unsigned char)command[0] == MPR_CMD_READ){
+        response[0] = (char)(MPR_STATUS_POWERED | (sim_converting ? MPR_STATUS_BUSY : 0));
+        if (length >= 4){
+            response[1] = (char)(sim_output >> 16);
+            response[2] = (char)(sim_output >> 8);
+            response[3] = (char)sim_output;
+        }
+    }
+    return true;
+}
+
+unsigned long hal_now_us() {
+    return sim_time_us;
+}
+
+void hal_wait_us(unsigned long delay_us) {
+    sim_time_us += delay_us;
+}
+
+void hal_eoc_arm() {
+}
+
+void hal_eoc_wait(unsigned long timeout_us) {
+    sim_update_conversion();
+    if (sim_converting){
+        unsigned long remaining_us = SIM_CONVERSION_US - (sim_time_us - sim_conversion_start_us);
+        sim_time_us += remaining_us < timeout_us ? remaining_us : timeout_us;
+    }
+}
+
+uint32_t hal_bench_ticks() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char *hal_bench_unit() {
+    return "ns";
+}
@@ -0,0 +1,29 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       sim_sensor.h
+* Description: Simulated MPR sensor and virtual clock of the host build. sim_hal.cpp implements bp_hal.h on top of them: the simulated sensor
+* answers the same SPI commands as the real one (0xAA starts a conversion, 0xF0 returns the status byte and the 24 bit output), the busy flag
+* and the EOC signal follow the conversion time, and every wait only advances the virtual clock.
+* In replay mode the simulated sensor instead returns the readings of a recorded session one by one, each read as soon as it is requested.
+*/
+
+#ifndef SIM_SENSOR_H
+#define SIM_SENSOR_H
+
+#include <stddef.h>
+#include "session_record.h"
+
+#define SIM_CONVERSION_US 5000          // Conversion time of the simulated sensor
+
+// Cuff pressure in mmHg at a point of the virtual time, context is passed through unchanged
+typedef double (*SIM_PRESSURE_SOURCE)(unsigned long time_us, void *context);
+
+void sim_reset();                                   // Virtual time 0, no conversion running
+void sim_set_pressure_source(SIM_PRESSURE_SOURCE source, void *context);
+void sim_advance_to(unsigned long time_us);         // Moves the virtual clock forward (never backwards)
+unsigned long sim_conversion_count();               // Number of conversions started since sim_reset()
+long sim_pressure_to_output(double pressure);       // Transfer function B: pressure in mmHg to the 24 bit sensor output
+void sim_replay(const SESSION_ENTRY *samples, size_t count);   // Replays recorded readings (sensor readings only), 0 returns to simulation
+size_t sim_replay_remaining();                      // Recorded readings that were not read yet
+
+#endif
@@ -0,0 +1,171 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       waveform_generator.cpp
+* Description: Synthetic oscillometric waveforms, see waveform_generator.h.
+*/
+
+#include "waveform_generator.h"
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bp_config.h"
+#include "sim_sensor.h"
+
+#define WAVEFORM_PULSE_RISE_S 0.12      // Time from the onset of a beat to its pressure peak
+#define WAVEFORM_MIN_BEAT_S 0.25        // Beat intervals drawn with a large HRV are limited to 240 bpm
+
+// SplitMix64: a small, fully specified generator, so the same seed gives the same waveform with every compiler and standard library
+static uint64_t splitmix64(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double uniform(uint64_t &state) {
+    return ((splitmix64(state) >> 11) + 0.5) * (1.0 / 9007199254740992.0);   // (0, 1)
+}
+
+static double gaussian(uint64_t &state) {
+    double u1 = uniform(state);
+    double u2 = uniform(state);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+void waveform_default_parameters(WAVEFORM_PARAMETERS &parameters) {
+    parameters.inflate_start_s = 2.0;
+    parameters.inflation_rate = 30.0;
+    parameters.peak_pressure = 210.0;
+    parameters.deflation_rate = 3.0;
+    parameters.systolic = 120.0;
+    parameters.diastolic = 80.0;
+    parameters.map = 93.0;
+    parameters.max_amplitude = 2.0;
+    parameters.envelope = WAVEFORM_ENVELOPE_GAUSSIAN;
+    parameters.heart_rate = 72.0;
+    parameters.hrv = 0.0;
+    parameters.noise = 0.0;
+    parameters.artifacts_per_minute = 0.0;
+    parameters.artifact_amplitude = 10.0;
+    parameters.seed = 1;
+}
+
+bool waveform_parse_option(WAVEFORM_PARAMETERS &parameters, const char *name, const char *value) {
+    double number = atof(value);
+    if (!strcmp(name, "--inflate-at")) parameters.inflate_start_s = number;
+    else if (!strcmp(name, "--inflation")) parameters.inflation_rate = number;
+    else if (!strcmp(name, "--peak")) parameters.peak_pressure = number;
+    else if (!strcmp(name, "--deflation")) parameters.deflation_rate = number;
+    else if (!strcmp(name, "--sbp")) parameters.systolic = number;
+    else if (!strcmp(name, "--dbp")) parameters.diastolic = number;
+    else if (!strcmp(name, "--map")) parameters.map = number;
+    else if (!strcmp(name, "--amplitude")) parameters.max_amplitude = number;
+    else if (!strcmp(name, "--envelope")) parameters.envelope = strcmp(value, "triangular") ? WAVEFORM_ENVELOPE_GAUSSIAN : WAVEFORM_ENVELOPE_TRIANGULAR;
+    else if (!strcmp(name, "--hr")) parameters.heart_rate = number;
+    else if (!strcmp(name, "--hrv")) parameters.hrv = number;
+    else if (!strcmp(name, "--noise")) parameters.noise = number;
+    else if (!strcmp(name, "--artifacts")) parameters.artifacts_per_minute = number;
+    else if (!strcmp(name, "--artifact-amplitude")) parameters.artifact_amplitude = number;
+    else if (!strcmp(name, "--seed")) parameters.seed = strtoul(value, 0, 0);
+    else return false;
+    return true;
+}
+
+void waveform_init(WAVEFORM &waveform, const WAVEFORM_PARAMETERS &parameters) {
+    waveform.parameters = parameters;
+    waveform.deflate_start_s = parameters.inflate_start_s + parameters.peak_pressure / parameters.inflation_rate;
+    waveform.end_s = waveform.deflate_start_s + parameters.peak_pressure / parameters.deflation_rate;
+
+    uint64_t state = parameters.seed;
+    waveform.beat_times.clear();
+    double mean_interval = 60.0 / parameters.heart_rate;
+    for (double beat = uniform(state) * mean_interval; beat < waveform.end_s; ){
+        waveform.beat_times.push_back(beat);
+        beat += std::max(WAVEFORM_MIN_BEAT_S, mean_interval * (1.0 + parameters.hrv * gaussian(state)));
+    }
+
+    state = parameters.seed ^ 0xA5A5A5A5A5A5A5A5ULL;   // Separate stream, so changing the artifact rate does not change the beats
+    waveform.artifacts.clear();
+    if (parameters.artifacts_per_minute > 0.0){
+        double mean_gap = 60.0 / parameters.artifacts_per_minute;
+        for (double start = -log(uniform(state)) * mean_gap; start < waveform.end_s; start += -log(uniform(state)) * mean_gap){
+            WAVEFORM_ARTIFACT artifact;
+            artifact.start_s = start;
+            artifact.duration_s = 0.3 + 0.7 * uniform(state);
+            artifact.amplitude = parameters.artifact_amplitude * (0.5 + 0.5 * uniform(state)) * (uniform(state) < 0.5 ? -1.0 : 1.0);
+            waveform.artifacts.push_back(artifact);
+        }
+    }
+}
+
+double waveform_cuff_pressure(const WAVEFORM &waveform, double time_s) {
+    const WAVEFORM_PARAMETERS &parameters = waveform.parameters;
+    if (time_s < parameters.inflate_start_s || time_s >= waveform.end_s){
+        return 0.0;
+    }
+    if (time_s < waveform.deflate_start_s){
+        return (time_s - parameters.inflate_start_s) * parameters.inflation_rate;
+    }
+    return parameters.peak_pressure - (time_s - waveform.deflate_start_s) * parameters.deflation_rate;
+}
+
+// Pulse amplitude at a cuff pressure. Both shapes equal Rs times the maximum at the systolic and Rd times the maximum at the diastolic pressure
+static double envelope(const WAVEFORM_PARAMETERS &parameters, double cuff) {
+    double rs = (SYSTOLIC_LOWER_CHAR_RATIO + SYSTOLIC_UPPER_CHAR_RATIO) / 2.0;
+    double rd = (DIASTOLIC_LOWER_CHAR_RATIO + DIASTOLIC_UPPER_CHAR_RATIO) / 2.0;
+    bool above_map = cuff > parameters.map;
+    double ratio = above_map ? rs : rd;
+    double distance = above_map ? (cuff - parameters.map) / (parameters.systolic - parameters.map)
+                                : (parameters.map - cuff) / (parameters.map - parameters.diastolic);
+    if (parameters.envelope == WAVEFORM_ENVELOPE_TRIANGULAR){
+        return parameters.max_amplitude * std::max(0.0, 1.0 - (1.0 - ratio) * distance);
+    }
+    return parameters.max_amplitude * pow(ratio, distance * distance);    // exp(-(x / w)^2) with w chosen to pass through the ratio at distance 1
+}
+
+// Normalized pressure pulse: fast systolic upstroke to 1, then an exponential run-off until the next beat
+static double pulse_shape(double since_onset_s, double interval_s) {
+    if (since_onset_s < WAVEFORM_PULSE_RISE_S){
+        double rise = sin(0.5 * M_PI * since_onset_s / WAVEFORM_PULSE_RISE_S);
+        return rise * rise;
+    }
+    double decay_s = (interval_s - WAVEFORM_PULSE_RISE_S) / 3.0;
+    return exp(-(since_onset_s - WAVEFORM_PULSE_RISE_S) / std::max(decay_s, 0.01));
+}
+
+double waveform_pressure(const WAVEFORM &waveform, unsigned long time_us) {
+    const WAVEFORM_PARAMETERS &parameters = waveform.parameters;
+    double time_s = time_us / 1e6;
+    double cuff = waveform_cuff_pressure(waveform, time_s);
+    double pressure = cuff;
+
+    if (cuff > 0.0){
+        std::vector<double>::const_iterator next = std::upper_bound(waveform.beat_times.begin(), waveform.beat_times.end(), time_s);
+        if (next != waveform.beat_times.begin()){
+            double onset = *(next - 1);
+            double interval = next != waveform.beat_times.end() ? *next - onset : 60.0 / parameters.heart_rate;
+            pressure += envelope(parameters, cuff) * pulse_shape(time_s - onset, interval);
+        }
+    }
+    for (size_t i = 0; i < waveform.artifacts.size(); i++){
+        const WAVEFORM_ARTIFACT &artifact = waveform.artifacts[i];
+        if (time_s >= artifact.start_s && time_s < artifact.start_s + artifact.duration_s){
+            pressure += artifact.amplitude * sin(M_PI * (time_s - artifact.start_s) / artifact.duration_s);
+        }
+    }
+    if (parameters.noise > 0.0){
+        uint64_t state = parameters.seed * 0x2545F4914F6CDD1DULL ^ time_us;    // Noise depends on the time only, not on the query order
+        pressure += parameters.noise * gaussian(state);
+    }
+    return pressure;
+}
+
+long waveform_counts(const WAVEFORM &waveform, unsigned long time_us) {
+    return sim_pressure_to_output(waveform_pressure(waveform, time_us));
+}
+
+double waveform_pressure_source(unsigned long time_us, void *waveform) {
+    return waveform_pressure(*(const WAVEFORM *)waveform, time_us);
+}
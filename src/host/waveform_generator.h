@@ -0,0 +1,62 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       waveform_generator.h
+* Description: Parametric generator of synthetic oscillometric cuff pressure waveforms for the host build. A measurement is modelled as
+* a linear inflation, a linear release from the peak pressure, and one pressure pulse per heart beat riding on the cuff pressure. The pulse
+* amplitude follows an envelope over the cuff pressure that peaks at the true MAP and crosses the characteristic ratios Rs and Rd of the
+* algorithm at the true systolic and diastolic pressures, so the expected result of every run is known. Beat to beat variability, sensor
+* noise and motion artifacts are drawn from a seeded generator, and the noise is a pure function of the seed and the time, so a waveform
+* is reproducible bit for bit at any sample rate and whatever the order of the queries. waveform_counts() applies transfer function B
+* (OUTPUT_MIN/OUTPUT_MAX) including the 24 bit quantization and clipping of the sensor.
+*/
+
+#ifndef WAVEFORM_GENERATOR_H
+#define WAVEFORM_GENERATOR_H
+
+#include <stddef.h>
+#include <vector>
+
+#define WAVEFORM_ENVELOPE_GAUSSIAN 0    // Half Gaussian on each side of MAP
+#define WAVEFORM_ENVELOPE_TRIANGULAR 1  // Straight lines from MAP through the systolic and diastolic points down to zero
+
+struct WAVEFORM_PARAMETERS {
+    double inflate_start_s;         // Time the pump starts (s), the cuff is at 0 mmHg before
+    double inflation_rate;          // mmHg per second
+    double peak_pressure;           // Pressure where the release starts (mmHg)
+    double deflation_rate;          // Linear release rate (mmHg per second)
+    double systolic;                // True systolic pressure (mmHg)
+    double diastolic;               // True diastolic pressure (mmHg)
+    double map;                     // True mean arterial pressure (mmHg), where the envelope peaks
+    double max_amplitude;           // Pulse amplitude at MAP (mmHg)
+    int envelope;                   // WAVEFORM_ENVELOPE_*
+    double heart_rate;              // Mean heart rate (bpm)
+    double hrv;                     // Standard deviation of the beat interval relative to its mean (0.05 = 5 %)
+    double noise;                   // Standard deviation of the white sensor noise (mmHg)
+    double artifacts_per_minute;    // Mean rate of motion artifacts
+    double artifact_amplitude;      // Largest pressure excursion of a motion artifact (mmHg)
+    unsigned long seed;
+};
+
+struct WAVEFORM_ARTIFACT {
+    double start_s;
+    double duration_s;
+    double amplitude;               // Signed peak excursion (mmHg)
+};
+
+struct WAVEFORM {
+    WAVEFORM_PARAMETERS parameters;
+    std::vector<double> beat_times;          // Onset of every heart beat (s)
+    std::vector<WAVEFORM_ARTIFACT> artifacts;
+    double deflate_start_s;
+    double end_s;                            // The cuff is empty again
+};
+
+void waveform_default_parameters(WAVEFORM_PARAMETERS &parameters);   // Healthy adult, 120/80 mmHg, MAP 93 mmHg, 72 bpm, no disturbances
+bool waveform_parse_option(WAVEFORM_PARAMETERS &parameters, const char *name, const char *value);   // --sbp 120 etc., false if unknown
+void waveform_init(WAVEFORM &waveform, const WAVEFORM_PARAMETERS &parameters);   // Draws the beats and artifacts of a run
+double waveform_cuff_pressure(const WAVEFORM &waveform, double time_s);    // Cuff pressure without pulses, noise and artifacts (mmHg)
+double waveform_pressure(const WAVEFORM &waveform, unsigned long time_us);   // Pressure seen by the sensor (mmHg)
+long waveform_counts(const WAVEFORM &waveform, unsigned long time_us);       // Raw 24 bit sensor output
+double waveform_pressure_source(unsigned long time_us, void *waveform);      // Adapter for sim_set_pressure_source()
+
+#endif
@@ -0,0 +1,94 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       work_stealing_pool.h
+* Description: Work-stealing thread pool of the host tools. run() spreads the task indices 0 .. count - 1 round robin over one deque per
+* worker. Every worker takes its next task from the back of its own deque and, once that is empty, steals from the front of the other
+* workers' deques, so workers that drew short tasks (a failed or truncated recording) help out the ones that drew long ones and all cores
+* stay busy until the batch is done. Each deque has its own mutex; the owner and a thief only meet on the same deque when it is nearly empty.
+*/
+
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(unsigned threads) : queues(threads ? threads : 1), steal_count(0) {}
+
+    unsigned threads() const {
+        return (unsigned)queues.size();
+    }
+
+    // Number of tasks that were executed by another worker than the one they were assigned to, during the last run()
+    unsigned long steals() const {
+        return steal_count.load();
+    }
+
+    // Calls task(worker, index) once for every index in 0 .. count - 1 and returns when all calls returned. worker identifies the calling
+    // thread (0 .. threads() - 1), so a task can use per worker state without locking.
+    template <typename F>
+    void run(size_t count, F task) {
+        steal_count = 0;
+        for (size_t i = 0; i < count; i++){
+            queues[i % queues.size()].tasks.push_back(i);
+        }
+        std::vector<std::thread> workers;
+        for (unsigned worker = 1; worker < queues.size(); worker++){
+            workers.push_back(std::thread([this, worker, &task]() { work(worker, task); }));
+        }
+        work(0, task);           // The calling thread is worker 0
+        for (size_t i = 0; i < workers.size(); i++){
+            workers[i].join();
+        }
+    }
+
+private:
+    struct TaskQueue {
+        std::mutex lock;
+        std::deque<size_t> tasks;
+    };
+
+    template <typename F>
+    void work(unsigned worker, F &task) {
+        size_t index;
+        while (take(worker, index)){
+            task(worker, index);
+        }
+    }
+
+    // Own tasks first (newest first), then the oldest task of the next non-empty deque. Nothing is added during a run, so a worker that
+    // finds every deque empty is done.
+    bool take(unsigned worker, size_t &index) {
+        {
+            TaskQueue &own = queues[worker];
+            std::lock_guard<std::mutex> guard(own.lock);
+            if (!own.tasks.empty()){
+                index = own.tasks.back();
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t offset = 1; offset < queues.size(); offset++){
+            TaskQueue &victim = queues[(worker + offset) % queues.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.tasks.empty()){
+                index = victim.tasks.front();
+                victim.tasks.pop_front();
+                steal_count++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<TaskQueue> queues;
+    std::atomic<unsigned long> steal_count;
+};
+
+#endif
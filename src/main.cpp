@@ -10,341 +10,615 @@
 * MAP pressure value. The diastolic pressure corresponds to the pressure value when the OMWE aplitude = Rd*MAP towards right of MAP pressure value.
 * For this project, we took the Rs and Rd values and algorithm implementation strategies from a couple of sources like:
 * https://www.nature.com/articles/s41371-019-0196-9
+* This file contains the target specific part (mbed drivers, threads, console output). The algorithm itself is in bp_algorithm.cpp and the
+* sensor protocol in mpr_acquisition.cpp, both of which are shared with the host build (src/host).
 */
 
 
 #include <mbed.h>
+#include <atomic>
+#include <stdarg.h>
+#include "benchmark.h"
+#include "bp_hal.h"
+#include "bp_monitor.h"
+#include "cycle_profile.h"
+#include "log_buffer.h"
+#include "mpr_acquisition.h"
+#include "session_record.h"
+#include "spsc_ring.h"
+#include "telemetry.h"
 
-// The given sensor follows transfer function B as per datasheet. MAX output for trans function B = 22.5% of max value possible for 24 bits = 3774873
-// Min output value = 2.5% of max value possible for 24 bits = 419430
-#define OUTPUT_MAX 3774873.0  // Maximum value of 24 bit output from sensor 
-#define OUTPUT_MIN 419430     // Minimum value of 24 bit output from sensor
-#define PRESSURE_MAX 300.0    // Maximum possible pressure that could be measured (300 mmHg)
-#define PRESSURE_MIN 0.0      // Minimum possible pressure that could be measured (0 mmHg)
-#define MIN_OMWE_THRESH 70.0   // Minimum OMWE graph filter for checking MAP values (helps to eradicate edge noices)
-#define MAX_OMWE_THRESH 160.0  // Maximum OMWE graph filter for checking MAP values (helps to eradicate edge noices)
-#define MAP_ERROR_THRESH 0.5   // Maximum supported error threshold while calculating the pressure position at Systolic and Diastolic pressure points in OMWE graph
-#define SYSTOLIC_LOWER_CHAR_RATIO 0.45  // Lower bound of Rs
-#define SYSTOLIC_UPPER_CHAR_RATIO 0.73  // Upper bound of Rs 
-#define DIASTOLIC_LOWER_CHAR_RATIO 0.69 // Lower bound of Rd
-#define DIASTOLIC_UPPER_CHAR_RATIO 0.83 // Upper bound of Rd
-#define LOWER_PULSE_RANGE 35.0          // Minimum practical pulse (bpm)
-#define UPPER_PULSE_RANGE 150.0         // Maximum practical pulse (bpm)
-
-// Structure Containing parameters related to BP like Systolic and Diastolic BPs and parameters related MAA algorithm for BP estimation
-struct BP_PARAMETER {
-    double systolic_bloodpressure;
-    double diastolic_bloodpressure;
-    double systolic_char_ratio;
-    double diastolic_char_ratio;
-};
+#ifndef MPR_EOC_PIN
+#define MPR_EOC_PIN PA_5                // Pin wired to the EOC output of the MPR sensor (only used with MPR_WAIT_EOC)
+#endif
+#ifndef MPR_SPI_ASYNC
+#if DEVICE_SPI_ASYNCH
+#define MPR_SPI_ASYNC 1                 // 1: SPI exchanges with the sensor use the asynchronous (DMA) transfer API of mbed
+#else
+#define MPR_SPI_ASYNC 0
+#endif
+#endif
+#define SAMPLE_QUEUE_DEPTH 64           // Number of raw samples that can wait between the acquisition thread and the processing loop (power of two)
+#define TELEMETRY_OUTPUT_TEXT 0         // Human readable console messages
+#define TELEMETRY_OUTPUT_BINARY 1       // COBS framed binary records of every sample, OMWE point and result (see include/telemetry.h)
+#ifndef TELEMETRY_OUTPUT
+#define TELEMETRY_OUTPUT TELEMETRY_OUTPUT_TEXT   // The binary stream needs a faster serial line than 9600 baud, e.g. 115200 in mbed_app.json
+#endif
+#ifndef SESSION_RECORDING
+#define SESSION_RECORDING 0             // 1: keep every raw reading in RAM and send the session image at the end (see include/session_record.h)
+#endif
+#define SESSION_IMAGE_ENTRIES 8192      // Readings and events the session image can hold (64 KB, about 160 s at 50 Hz)
+#if SESSION_RECORDING && TELEMETRY_OUTPUT != TELEMETRY_OUTPUT_BINARY
+#error "SESSION_RECORDING sends the session image as binary telemetry and needs TELEMETRY_OUTPUT_BINARY"
+#endif
+#ifndef BENCHMARK_MODE
+#define BENCHMARK_MODE 0                // 1: run the pipeline benchmarks of benchmark.h and print CSV results instead of measuring
+#endif
+#define LOG_BUFFER_SIZE 2048            // Bytes of console output that can wait for the serial line (power of two)
+#define LOG_LINE_MAX 160                // Longest message formatted by log_printf()
+#define LOG_DATA_FLAG 0x1               // Event flag raised by log_printf() when new output is waiting for the log thread
+#define SAMPLE_TICK_FLAG 0x1            // Event flag raised by the sampling Ticker to start a new MPR conversion
+#define SAMPLE_READY_FLAG 0x2           // Event flag raised by the acquisition thread when a sample was pushed into the sample ring
+#define CONVERSION_DONE_FLAG 0x4        // Event flag raised by the EOC interrupt when the MPR sensor finished a conversion
+#define SPI_DONE_FLAG 0x8               // Event flag raised by the SPI event callback when an asynchronous transfer completed
+#define CALIBRATE_FLAG 0x10             // Event flag raised by run_measurement() to have the acquisition thread calibrate the sensor
+#define CALIBRATION_DONE_FLAG 0x20      // Event flag raised by the acquisition thread when the zero reference of the measurement is ready
+#define SPI_TRANSFER_TIMEOUT 5ms        // Longest wait for an asynchronous SPI transfer, 4 bytes take 0.32 ms at 100 kHz
+#define ACQUISITION_DRAIN_TIME 20ms     // Longest reading: two SPI exchanges of SPI_TRANSFER_TIMEOUT and a conversion of MPR_CONVERSION_TIMEOUT_US
 
-// Structure containing pulse value and the number of data points using which the pulse was evaluated
-struct PULSE_READING {
-    double pulse_value;
-    long pulse_data_count;
+// Structure collecting the mean and maximum of a latency measured on every sample
+struct LATENCY_STATS {
+    unsigned long sample_count;
+    unsigned long max_us;
+    unsigned long long total_us;
 };
 
 Ticker pressure_gradient;
+Ticker sampling_ticker;             // Hardware timer that paces the MPR conversions at SAMPLE_RATE_HZ
 Timer pressure_display_timer;
-Timer pulse_count_timer;
+Timer pulse_count_timer;            // Time base for the sample timestamps and the OMWE time buffer
+EventFlags acquisition_flags;       // Signals the acquisition thread that a new conversion is due
+EventFlags processing_flags;        // Signals the processing loop that new samples are available
+Thread acquisition_thread(osPriorityRealtime);   // Thread performing the SPI exchange with the MPR sensor
+SpscRing<PRESSURE_SAMPLE, SAMPLE_QUEUE_DEPTH> sample_ring;   // Raw samples waiting to be processed (acquisition thread -> main loop)
+LogBuffer<LOG_BUFFER_SIZE> log_buffer;   // Console output waiting for the serial line (main thread -> log thread)
+EventFlags log_flags;               // Signals the log thread that output is waiting
+Thread log_thread(osPriorityLow);   // Thread draining the log buffer to the console
 SPI spi_comm(SPI_MOSI, SPI_MISO, SPI_SCK);
 DigitalOut cs(PB_6);
 DigitalOut active_flag(LED2);       // LED indicator for active data plotting for OMWE
 DigitalOut max_pressure(LED3);      // LED indicator to start releasing cuff pressure
 DigitalOut flux_warning(LED4);      // LED indicator for high pressure release
 DigitalIn dataread_push_button(USER_BUTTON); //Removed the push button
-double current_pressure = 0;
-double release_rate = 0;
-double buffer_queue[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
-double omwegraph_absicissa_buffer[1000];    // Oscillometeric Waveform Envelope (OMWE) graph x values.
-double omwegraph_ordinate_buffer[1000];    // Oscillometric Waveform Envelope (OMWE) graph y values
-double omwe_buffer_time[1000];       // Time buffer for storing time relative to first record when peak in OMWE was detected
-double pressure_diff = 0.0;
-double previous_pressure_diff = 0.0;
-double peak_pressure_diff = 0.0;
-double Mean_Arterial_Pressure;                    // Mean Arterial Pressure (MAP) value to be estimated for BP evaluation
-BP_PARAMETER final_blood_pressure;       // Variable containing the final BP value
-long caliberated_MIN_OUT = 0;
-long iteration = 0;
-long omwebuffer_pointer = 0;        // A pointer for storing the latest data location of x and y buffers of OMWE plot
-long omwetime_buffer_pointer = 0;   // A pointer for storing the latest data location of the OMWE time buffer
-bool caution_flag = false;           // Flag to indicate if pressure release is too fast!
-bool change_warnflag;
-bool active_recordflag = false;    // Flag to indicate if data measured is being recorded for OMWE plot.
-bool end_record = false;
-long measure_pressure();             // Function routine to measure pressure using MPR sensor
-PULSE_READING measure_pulse();          // FUnction routine to evaluate pulse from the OMWE time buffer
+#if MPR_ACQUISITION_MODE == MPR_WAIT_EOC
+InterruptIn mpr_eoc(MPR_EOC_PIN);   // End of conversion output of the MPR sensor
+#endif
+MeasurementSession<sample_t> measurement;   // State of the measurement algorithm, owned by the processing loop
+LATENCY_STATS conversion_latency = {0, 0, 0};   // Conversion start -> output read, measured by the acquisition thread
+LATENCY_STATS processing_latency = {0, 0, 0};   // Conversion start -> sample processed by the main loop
+#if CYCLE_PROFILING
+CYCLE_STATS gradient_isr_profile;   // Timing of check_pressure_gradient_ISR(), only written by the ISR and copied with interrupts masked
+#endif
+std::atomic<bool> gradient_check_due(false);   // Set by the gradient ISR, the check itself runs in the processing loop
+long calibration_offset = 0;        // Zero reference of the measurement, written by the acquisition thread before CALIBRATION_DONE_FLAG
+std::atomic<unsigned long> spi_error_count(0);   // SPI exchanges that were rejected, timed out or ended with an error event
+volatile int spi_transfer_event = 0;     // Event of the last asynchronous SPI transfer, written by spi_done_ISR()
+#if SESSION_RECORDING
+uint8_t session_image[SESSION_HEADER_SIZE + SESSION_IMAGE_ENTRIES * SESSION_ENTRY_SIZE];   // Raw readings of the measurement
+std::atomic<uint32_t> session_entry_count(0);    // Entries reserved in the session image, may exceed SESSION_IMAGE_ENTRIES when it is full
+#endif
+void spi_done_ISR(int event);        // SPI event callback that ends an asynchronous exchange
+void mpr_eoc_ISR();                  // An Interrupt Service Routine attached to the EOC pin of the MPR sensor
+void sample_tick_ISR();              // An Interrupt Service Routine attached to the sampling Ticker to start a new conversion
+void acquisition_loop();             // Body of the acquisition thread, reads the sensor on every sampling tick
+void calibrate_acquisition();        // Prepares the acquisition of a new measurement and calibrates the sensor, on the acquisition thread
+void wait_acquisition_drained();     // Waits until the acquisition thread finished the reading of the last sampling tick
+void log_printf(const char *format, ...);   // Formats a message into the log buffer without waiting for the serial line
+void log_loop();                     // Body of the log thread, writes the buffered output to the console
+void log_flush();                    // Blocks until all buffered output was written to the console
+void telemetry_send(uint8_t type, const uint8_t *payload, size_t length);   // Frames a binary record into the log buffer
+void telemetry_sample(const PRESSURE_SAMPLE &sample, sample_t normalized_pressure);   // Binary record of a processed sample
+void telemetry_omwe_point(unsigned long time_ms, sample_t pressure, sample_t amplitude);   // Binary record of a new OMWE graph point
+void telemetry_results(const BP_PARAMETER &bp, const PULSE_READING &pulse);   // Binary records of the final BP and pulse values
+void session_record_sample(const PRESSURE_SAMPLE &sample);   // Sample recorder appending every raw reading to the session image
+void session_record_event(unsigned long timestamp_us, long event);   // Appends an event entry to the session image
+void session_send();                     // Sends the session image as TELEMETRY_SESSION records
+void print_bench_result(const BENCH_RESULT &result);   // Prints one benchmark result as a CSV line
+void record_latency(LATENCY_STATS &stats, unsigned long latency_us);   // Adds one latency measurement to the statistics
+void print_latency(const char *name, const LATENCY_STATS &stats);     // Displays the mean and maximum of a latency
 void check_pressure_gradient_ISR();      // An Interrupt Service Routine attached to a Ticker to check if pressure release is too fast.
-void auto_caliberate();              // This is an auto-caliberation routine that caliberates the sensor output at the start of the pressure measurement to be the 0 pressure point
-void MAP_calculator();               // Routine to calculate MAP value from the OMWE graph
-BP_PARAMETER Systolic_and_diastolic_bp_calculator();   // Routine to calculate the systolic and diastolic blood pressure
-double calculate_normalized_pressure();   // To find peak values in OMWE, we compare the current pressure reading with a set of normalized pressure values over the previous readings. This routine calculates it
+void update_indicators();                // Shows the algorithm state on the LEDs
+void run_measurement();                  // Calibration, sampling and results of one measurement
 
  int main() {
-    BP_PARAMETER bp;
-    PULSE_READING pulse;
+    log_thread.start(log_loop);        // All console output goes through the log buffer, so no output can stall the sampling
+#if BENCHMARK_MODE || CYCLE_PROFILING
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;   // Enable the DWT cycle counter used by hal_bench_ticks()
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+#if BENCHMARK_MODE
+    log_printf("\nstage,sample_type,size,calls,%s_per_call", hal_bench_unit());
+    run_benchmarks(print_bench_result);
+    log_printf("\n");
+    log_flush();
+    return 0;
+#endif
   //////////////////////////// I use SPI protocol to interface with MPR Sensor. The following configures the SPI protocol using mbed API//////////////
     cs = 1;                            // Disabling slave select
     spi_comm.format(8, 1);             // SPI data transmission format
     spi_comm.frequency(100000);        // SPI communication frequency
-    auto_caliberate();                 // Before starting the actual reading, Tare/Caliberate the base MPR sensor ouput to 0.
-    change_warnflag = false;
-    pressure_gradient.attach(&check_pressure_gradient_ISR, 1);  // Watchdog ticker to periodically check for pressure release rate 
-    printf("\nNow measuring pressure!...");
+#if MPR_SPI_ASYNC
+    spi_comm.set_dma_usage(DMA_USAGE_ALWAYS);   // Let the DMA move the bytes so the core is free during bus activity
+#endif
+#if MPR_ACQUISITION_MODE == MPR_WAIT_EOC
+    mpr_eoc.rise(&mpr_eoc_ISR);        // EOC goes high as soon as the output of a conversion can be read
+#endif
+    acquisition_thread.start(acquisition_loop);
+    while (true) {
+        run_measurement();
+        log_printf("\n Press the USER button to start the next measurement\n");
+        while (!dataread_push_button){
+            ThisThread::sleep_for(50ms);
+        }
+        while (dataread_push_button){      // Wait for the release, so the same press does not also start the OMWE recording
+            ThisThread::sleep_for(50ms);
+        }
+    }
+}
+
+/***Function running one complete measurement*****
+Resets the algorithm state and the statistics, calibrates the sensor, samples until the end of the measurement is detected and reports the
+results. It can be called any number of times after the drivers and threads were started in main(), so measurements can follow each other
+without a reboot. The sensor and the acquisition state belong to the acquisition thread (mpr_acquisition.h), so the calibration is requested
+with CALIBRATE_FLAG and run there; the sampling ticker is only attached once it is done. */
+
+void run_measurement() {
+    BP_PARAMETER bp;
+    PULSE_READING pulse;
+    static PRESSURE_SAMPLE samples[PROCESS_BLOCK_SIZE];
+    static sample_t normalized_pressures[PROCESS_BLOCK_SIZE];
+    measurement.reset();
+    while (sample_ring.pop(samples, PROCESS_BLOCK_SIZE) > 0){       // Samples left over from the previous measurement
+    }
+    conversion_latency = processing_latency = LATENCY_STATS{0, 0, 0};
+    cycle_profile_reset();
+#if CYCLE_PROFILING
+    core_util_critical_section_enter();
+    gradient_isr_profile = CYCLE_STATS();
+    core_util_critical_section_exit();
+#endif
+    pulse_count_timer.reset();
+    pulse_count_timer.start();            // Starting the timer for the sample timestamps and the OMWE time buffer
+#if SESSION_RECORDING
+    session_entry_count = 0;
+    session_put_header(session_image, SAMPLE_RATE_HZ);
+#endif
+    log_printf("\nCaliberating the sensor now!..");  
+    acquisition_flags.set(CALIBRATE_FLAG);             // Before starting the actual reading, Tare/Caliberate the base MPR sensor ouput to 0.
+    processing_flags.wait_any(CALIBRATION_DONE_FLAG);
+    measurement.set_calibration(calibration_offset);
+    log_printf("\nCaliberation complete!");
+    pressure_gradient.attach(&check_pressure_gradient_ISR, 1s);  // Watchdog ticker to periodically check for pressure release rate 
+    log_printf("\nNow measuring pressure!... (sample type: %s)", SampleTraits<sample_t>::name());
     pressure_display_timer.start();       // Timer to time the pressure display on monitor
-    pulse_count_timer.start();            // Starting the timer for OMWE time buffer
-	while (!end_record) {          // Keep measuring pressure until end_record is active
-		measure_pressure();    
-		wait_us(200000);
+    sampling_ticker.attach(&sample_tick_ISR, std::chrono::microseconds(1000000 / SAMPLE_RATE_HZ));   // Fixed rate sampling of the MPR sensor
+	while (!measurement.complete()) {          // Keep measuring pressure until the end of the measurement was detected
+		// All samples waiting in the ring (up to a block) are processed together. At the sample rate the processing loop keeps up with,
+		// this is a single sample and adds no latency; if it falls behind, the blocks grow and the cost per sample falls.
+		long count = sample_ring.pop(samples, PROCESS_BLOCK_SIZE);
+		if (count == 0){
+			processing_flags.wait_any(SAMPLE_READY_FLAG);   // Sleep until the acquisition thread delivers the next sample
+			continue;
+		}
+		if (dataread_push_button){          // read data from the sensor is not recorded until the record_push_button is i pressed to neglet unwanted data
+#if SESSION_RECORDING
+			if (!measurement.recording()){
+				session_record_event(samples[0].timestamp_us, SESSION_EVENT_RECORD_START);
+			}
+#endif
+			measurement.start_recording();
+		}
+		long omwe_points = measurement.omwe_points();
+		count = measurement.process_pressure_block(samples, count, normalized_pressures);
+		for (long i = 0; i < count; i++){
+			telemetry_sample(samples[i], normalized_pressures[i]);
+			record_latency(conversion_latency, samples[i].conversion_us);
+		}
+		for (long point = omwe_points; point < measurement.omwe_points(); point++){     // Stamped with the last sample of the block
+			telemetry_omwe_point(samples[count - 1].timestamp_us / 1000, measurement.omwe_pressure(point), measurement.omwe_amplitude(point));
+		}
+		unsigned long processed_us = hal_now_us();
+		for (long i = 0; i < count; i++){
+			record_latency(processing_latency, processed_us - samples[i].timestamp_us);
+		}
+		if (gradient_check_due.exchange(false)){
+			PROFILE_BEGIN(PROFILE_GRADIENT_CHECK);
+			measurement.check_pressure_gradient();
+			PROFILE_END(PROFILE_GRADIENT_CHECK);
+		}
+		update_indicators();
+		if (pressure_display_timer.elapsed_time() > 1s){             // to display the data on screen
+			log_printf("\n Recorded pressure = %lf. Pressure release rate = %lf mmHg per second ",(double)normalized_pressures[count - 1], (double)measurement.release_rate());
+			pressure_display_timer.reset();
+		}
 	}
+    sampling_ticker.detach();
+    pressure_gradient.detach();
+    wait_acquisition_drained();
     pulse_count_timer.stop();
-    printf("\n Calculating Systolic and Diastolic pressure values.....");
-    bp = Systolic_and_diastolic_bp_calculator();
+    log_printf("\n Samples dropped by the acquisition ring = %lu", (unsigned long)sample_ring.overruns());
+#if MPR_SPI_ASYNC
+    log_printf("\n SPI transfer errors = %lu", spi_error_count.load());
+#endif
+    log_printf("\n Console messages dropped = %lu", (unsigned long)log_buffer.dropped());
+    print_latency("Conversion latency", conversion_latency);
+    print_latency("Sample to processing latency", processing_latency);
+    log_printf("\n Calculating Systolic and Diastolic pressure values.....");
+    bp = measurement.Systolic_and_diastolic_bp_calculator();
     if (bp.systolic_bloodpressure < 0 || bp.diastolic_bloodpressure < 0){     // If the bp measurement failed, the BP values will be set negative
-        printf("\n Pressure measurement unsuccessful! Perform again...");
+        log_printf("\n Pressure measurement unsuccessful! Perform again...");
     }
     else {
-        printf("\n Pressure measurement completed successfully!.");
+        log_printf("\n Pressure measurement completed successfully!.");
     }
-    printf("\n MAP value = %lf", Mean_Arterial_Pressure);
-    printf("\n Characteristic systolic deviation in graph = %lf", bp.systolic_char_ratio);
-    printf("\n Characteristic diastolic deviation in graph = %lf", bp.diastolic_char_ratio);
-    printf("\n Systolic pressure = %lf", bp.systolic_bloodpressure);
-    printf("\n Diastolic pressure = %lf", bp.diastolic_bloodpressure);
-    printf("\n Calculating Pulse...");
-    pulse = measure_pulse();
-    printf("\n Pulse measurement completed!");
+    log_printf("\n MAP value = %lf", (double)measurement.mean_arterial_pressure());
+    log_printf("\n Characteristic systolic deviation in graph = %lf", bp.systolic_char_ratio);
+    log_printf("\n Characteristic diastolic deviation in graph = %lf", bp.diastolic_char_ratio);
+    log_printf("\n Systolic pressure = %lf", bp.systolic_bloodpressure);
+    log_printf("\n Diastolic pressure = %lf", bp.diastolic_bloodpressure);
+    log_printf("\n Calculating Pulse...");
+    pulse = measurement.measure_pulse();
+    log_printf("\n Pulse measurement completed!");
     if (pulse.pulse_data_count == 0){
-        printf("\n No pulse Detected!. Perform again...");
+        log_printf("\n No pulse Detected!. Perform again...");
     }
     else {
-        printf("\n Your pulse = %lf. Number of reliable pulse values = %ld", pulse.pulse_value, pulse.pulse_data_count);
+        log_printf("\n Your pulse = %lf. Number of reliable pulse values = %ld", pulse.pulse_value, pulse.pulse_data_count);
     }
-   return 0;
+#if CYCLE_PROFILING
+    log_flush();                       // The report is longer than the free space the results may have left in the log buffer
+    core_util_critical_section_enter();
+    cycle_profile[PROFILE_GRADIENT_ISR] = gradient_isr_profile;
+    core_util_critical_section_exit();
+    log_printf("\n Stage timing (SystemCoreClock = %lu Hz):", (unsigned long)SystemCoreClock);
+    cycle_profile_print(log_printf);
+#endif
+    telemetry_results(bp, pulse);
+#if SESSION_RECORDING
+    session_send();
+#endif
+    log_flush();
 }
 
-/***Fuction to Measure Pulse using the OMWE graph time buffer*********
-OMWE time buffer collects the time at which the OMWE peaks were detected.
-This routine checks for the time between consecutive peaks and then checks if it comes under reliable pulse rate.
-Multiple such reliable data points are found and the average is taken to be the pulse value.
-The pulse_count gives the total number of pulse time data points using which the final pulse was evaluated.  */
-
-PULSE_READING measure_pulse() {
-    PULSE_READING pulse_data;
-    double pulse_upper_value = (60.0/LOWER_PULSE_RANGE)*1000.0;        // Upper value of pulse in time difference between the consecutive pulse peaks
-    double pulse_lower_value = (60.0/UPPER_PULSE_RANGE)*1000.0;        // Lower value of pulse in time difference between the consecutive pulse peaks
-    double pulse = 0.0;
-    double pulse_time_p2p;
-    long pulse_count = 0;
-    for (int i = 1; i < omwetime_buffer_pointer; i++){
-        pulse_time_p2p = omwe_buffer_time[i] - omwe_buffer_time[i - 1];   // Time interval between adjactent peaks
-        if (pulse_time_p2p > pulse_lower_value && pulse_time_p2p < pulse_upper_value){
-            pulse += pulse_time_p2p;
-            pulse_count++;
-        }
+/***Interrupt Service Routine (ISR) for checking an increased pressure release rate*****
+This ISR is attached to a Ticker, which is triggered every second to check for high release rate. i.e > 4 mmHg per sec. 
+The pressure state is owned by the processing loop, so the ISR only requests the check, which is done by check_pressure_gradient() 
+after the next sample has been processed. This avoids torn reads of the pressure values shared with the main loop. The ISR times itself into
+gradient_isr_profile rather than into the cycle_profile table of the processing loop. */
+
+
+void check_pressure_gradient_ISR() {
+  PROFILE_BEGIN(PROFILE_GRADIENT_ISR);
+  gradient_check_due = true;
+  PROFILE_END_INTO(PROFILE_GRADIENT_ISR, gradient_isr_profile);
+  return;
+}
+
+/***Function to show the algorithm state on the LEDs*****
+GREEN: the OMWE graph is being recorded, RED: maximum pressure reached, the cuff pressure can be released, BLUE: release rate too high */
+
+void update_indicators() {
+    active_flag = measurement.recording();
+    max_pressure = measurement.max_pressure_reached();
+    flux_warning = measurement.high_release_rate();
+}
+
+/***Hardware abstraction used by the MPR acquisition code (see bp_hal.h)*****/
+
+unsigned long hal_now_us() {
+    return (unsigned long)pulse_count_timer.elapsed_time().count();
+}
+
+void hal_wait_us(unsigned long delay_us) {
+    wait_us(delay_us);
+}
+
+void hal_eoc_arm() {
+    acquisition_flags.clear(CONVERSION_DONE_FLAG);
+}
+
+void hal_eoc_wait(unsigned long timeout_us) {
+    acquisition_flags.wait_any_for(CONVERSION_DONE_FLAG, std::chrono::milliseconds((timeout_us + 999) / 1000));   // The RTOS waits whole ms, never shorter than timeout_us
+}
+
+uint32_t hal_bench_ticks() {
+    return DWT->CYCCNT;
+}
+
+const char *hal_bench_unit() {
+    return "cycles";
+}
+
+/***Function for one SPI exchange with the MPR sensor*****
+The slave select pin frames the exchange. With MPR_SPI_ASYNC the bytes are moved by the SPI DMA using the asynchronous transfer() API of mbed:
+the calling thread sleeps on an event flag until spi_done_ISR() releases the slave select, so the core runs the processing loop during the bus
+activity instead of spinning on every byte. The buffers stay valid on the caller's stack as the call only returns after the transfer.
+A transfer the driver rejects (bus busy), one that ends with an error event and one whose callback does not come within
+SPI_TRANSFER_TIMEOUT (the transfer is aborted) fail the exchange: it returns false and is counted in spi_error_count. */
+
+bool mpr_spi_exchange(const char *command, char *response, int length) {
+     bool done = true;
+     PROFILE_BEGIN(PROFILE_SPI_EXCHANGE);
+     cs = 0;          // SS pin set to '0' to activate slave select before SPI communication starts 
+#if MPR_SPI_ASYNC
+     acquisition_flags.clear(SPI_DONE_FLAG);
+     if (spi_comm.transfer(command, length, response, length, callback(&spi_done_ISR), SPI_EVENT_ALL) != 0){
+         cs = 1;
+         done = false;
+     }
+     else if (acquisition_flags.wait_any_for(SPI_DONE_FLAG, SPI_TRANSFER_TIMEOUT) & osFlagsError){
+         spi_comm.abort_transfer();
+         cs = 1;
+         done = false;
+     }
+     else {
+         done = !(spi_transfer_event & SPI_EVENT_ERROR);
+     }
+     if (!done){
+         spi_error_count++;
+     }
+#else
+     spi_comm.write(command, length, response, length);
+     cs = 1;          // Set the SS pin to end communication
+#endif
+     PROFILE_END(PROFILE_SPI_EXCHANGE);
+     return done;
+}
+
+/***SPI event callback of the asynchronous transfers*****
+Called in interrupt context when the DMA transfer completed (or failed). Ends the exchange and wakes up the waiting thread. */
+
+void spi_done_ISR(int event) {
+  cs = 1;
+  spi_transfer_event = event;
+  acquisition_flags.set(SPI_DONE_FLAG);
+}
+
+/***Interrupt Service Routine (ISR) of the MPR end of conversion pin*****
+Wakes up the acquisition thread waiting in hal_eoc_wait(). */
+
+void mpr_eoc_ISR() {
+  acquisition_flags.set(CONVERSION_DONE_FLAG);
+}
+
+/***Interrupt Service Routine (ISR) of the sampling Ticker*****
+The SPI driver can not be used from interrupt context, so the ISR only raises an event flag and the acquisition thread starts the MPR conversion.
+This keeps the sampling instants on the hardware timer grid, independent of the time spent on analysis and display in the main loop. */
+
+void sample_tick_ISR() {
+  acquisition_flags.set(SAMPLE_TICK_FLAG);
+}
+
+/***Function preparing the acquisition of a new measurement*****
+Runs on the acquisition thread when run_measurement() raises CALIBRATE_FLAG, while the sampling ticker is detached: forgets the pipelined
+conversion of the previous measurement, installs the session recorder (so the calibration readings are recorded as well and the replay can
+calibrate the same way) and averages the sensor output at 0 mmHg into calibration_offset. */
+
+void calibrate_acquisition() {
+  reset_acquisition();
+#if SESSION_RECORDING
+  set_sample_recorder(session_record_sample);
+#endif
+  calibration_offset = auto_caliberate();
+  processing_flags.set(CALIBRATION_DONE_FLAG);
+}
+
+/***Function waiting for the end of the acquisition*****
+Once the sampling ticker is detached no new reading starts, but the acquisition thread may still be inside the reading of the last tick and
+push or record one more sample. That reading ends within ACQUISITION_DRAIN_TIME, even when every exchange and the conversion time out. */
+
+void wait_acquisition_drained() {
+  ThisThread::sleep_for(ACQUISITION_DRAIN_TIME);
+}
+
+/***Acquisition thread*****
+Waits for the sampling tick, reads the MPR sensor and pushes the raw sample into the lock-free sample ring that feeds the processing loop in main().
+Ticks that arrive while a conversion is still in progress are merged into one, so the effective rate is limited by the conversion time
+(about 90 Hz with MPR_WAIT_FIXED and up to about 180 Hz when the end of conversion is detected with MPR_WAIT_EOC or MPR_WAIT_BUSY_POLL).
+With MPR_PIPELINED the conversion overlaps the time between ticks and the rate is only limited by the sensor's own conversion rate.
+If the processing loop falls behind and the ring is full, the sample is dropped and counted by the ring's overrun counter. A sample whose SPI
+exchange failed carries no valid reading and is dropped as well, it was counted in spi_error_count. The calibration at the start of a
+measurement runs here too, so every function of mpr_acquisition.h is called from this thread only. */
+
+void acquisition_loop() {
+  while (true) {
+      uint32_t flags = acquisition_flags.wait_any(SAMPLE_TICK_FLAG | CALIBRATE_FLAG);
+      if (flags & CALIBRATE_FLAG){               // A tick left over from the previous measurement is dropped with it
+          calibrate_acquisition();
+          continue;
+      }
+#if MPR_PIPELINED
+      PRESSURE_SAMPLE sample = measure_pressure_pipelined();
+#else
+      PRESSURE_SAMPLE sample = measure_pressure();
+#endif
+      if (sample.status & MPR_STATUS_TRANSFER_FAILED){
+          continue;
+      }
+      if (sample_ring.push(sample)){
+          processing_flags.set(SAMPLE_READY_FLAG);
+      }
+  }
+}
+
+/***Functions for the session recording*****
+With SESSION_RECORDING every raw reading returned by the acquisition code (the calibration readings included) and the USER button event are
+appended to a RAM image as 8 byte entries. The acquisition thread and the main loop both append, so an entry slot is reserved with an atomic
+increment. The image stays in RAM during the measurement because erasing a flash sector would stall the core for far longer than a sampling
+period; once the measurement is complete it is sent in TELEMETRY_SESSION records, and tools/telemetry_decode.py writes it to session.bps.
+session_send() is called after wait_acquisition_drained(), so no reading is appended while the image is sent. */
+
+#if SESSION_RECORDING
+void session_append(const SESSION_ENTRY &entry) {
+    uint32_t index = session_entry_count.fetch_add(1);
+    if (index < SESSION_IMAGE_ENTRIES){
+        session_put_entry(session_image + SESSION_HEADER_SIZE + index * SESSION_ENTRY_SIZE, entry);
     }
-    if (pulse_count != 0){
-        pulse /= (double)pulse_count;
-        pulse = (1000/pulse) * (60.0);
+}
+
+void session_record_sample(const PRESSURE_SAMPLE &sample) {
+    SESSION_ENTRY entry = {sample.timestamp_us, sample.pressure_data, (unsigned char)sample.status};
+    session_append(entry);
+}
+
+void session_record_event(unsigned long timestamp_us, long event) {
+    SESSION_ENTRY entry = {timestamp_us, event, SESSION_EVENT};
+    session_append(entry);
+}
+
+void session_send() {
+    uint32_t entries = session_entry_count.load();
+    if (entries > SESSION_IMAGE_ENTRIES){
+        log_printf("\n Session image full, %lu readings were not recorded", (unsigned long)(entries - SESSION_IMAGE_ENTRIES));
+        entries = SESSION_IMAGE_ENTRIES;
     }
-    else {
-        pulse = -1;
+    uint32_t length = SESSION_HEADER_SIZE + entries * SESSION_ENTRY_SIZE;
+    uint8_t payload[4 + TELEMETRY_SESSION_CHUNK];
+    for (uint32_t offset = 0; offset < length; offset += TELEMETRY_SESSION_CHUNK){
+        uint32_t chunk = length - offset < TELEMETRY_SESSION_CHUNK ? length - offset : TELEMETRY_SESSION_CHUNK;
+        uint8_t *cursor = payload;
+        telemetry_put_u32(cursor, offset);
+        memcpy(cursor, session_image + offset, chunk);
+        log_flush();                   // Unlike the live records, no chunk of the image may be dropped
+        telemetry_send(TELEMETRY_SESSION, payload, 4 + chunk);
     }
-    pulse_data.pulse_value = pulse;
-    pulse_data.pulse_data_count = pulse_count;   
-    return pulse_data; 
 }
+#endif
 
-/*****Fuction to Systolic and Diastolic Pressure using OMWE graph X and Y cordinates  
-Useing MAA Algorithm to evaluate Systolic and Diastolic blood pressure values. 
-As a part of this, during the measure_pressure routine,the MAP (Mean Arterial Pressure) value would be found and the OMWE graph would be plotted after the user manually gestures the controller to start plotting by pressing
-the USER button. 
-The MAA algorithm tells that :
-Systolic Pressure = Pressure value (x cordinate) corresponding to (Rs*MAP) y cordinate in OMWE graph toward right of MAP peak. 
-Diastolic value corresponds to the pressure value at (Rd*MAP). 
-Here Rs and Rd are Systolic and Diastolic characteristic ratios. 
-Assuming Rs = (0.45 + 0.73)/2 = 0.59 and Rd = (0.69 + 0.83)/2 = 0.76 BP estimation using MAA algorithm. ****/
-
-BP_PARAMETER Systolic_and_diastolic_bp_calculator() {
-    double lower_systolic, upper_systolic, lower_diastolic, upper_diastolic;
-    double systolic_ordinate_value, diastolic_ordinate_value;
-    int systolic_buffer = -1, diastolic_buffer = -1;
-    double min_systolic_ordinate_error = MAP_ERROR_THRESH + 1;
-    double min_diastolic_ordinate_error = MAP_ERROR_THRESH + 1;
-    BP_PARAMETER bp_value;
-    // Here peak delta pressure corresponds to the ordinate of OMWE graph(Y-axis) corresponding to x
-    lower_systolic = SYSTOLIC_LOWER_CHAR_RATIO * peak_pressure_diff;
-    upper_systolic = SYSTOLIC_UPPER_CHAR_RATIO * peak_pressure_diff;
-    lower_diastolic = DIASTOLIC_LOWER_CHAR_RATIO * peak_pressure_diff;
-    upper_diastolic = DIASTOLIC_UPPER_CHAR_RATIO * peak_pressure_diff;
-    systolic_ordinate_value = (lower_systolic + upper_systolic)/2.0;           // Pressure peak value corresponding to Systolic pressure
-    diastolic_ordinate_value = (lower_diastolic + upper_diastolic)/2.0;        // Pressure peak value corresponding to Diastolic pressure
-    
-    // min_systolic_ordinate_error/min_diastolic_ordinate_error are used to find the closest y value in OMWE graph that matches with the characteristic pressure peaks
-    for (int i = 0; i < omwebuffer_pointer; i++){
-        if (abs(omwegraph_ordinate_buffer[i] -  systolic_ordinate_value) < min_systolic_ordinate_error){
-           if(omwegraph_absicissa_buffer[i] > 100 && omwegraph_absicissa_buffer[i] < 200) {          // Filter to check if pressure is reliable
-              min_systolic_ordinate_error = abs(omwegraph_ordinate_buffer[i] -  systolic_ordinate_value);
-              systolic_buffer = i;
-           }   
-        }
-        if (abs(omwegraph_ordinate_buffer[i] -  diastolic_ordinate_value) < min_diastolic_ordinate_error){
-           if(omwegraph_absicissa_buffer[i] > 50 && omwegraph_absicissa_buffer[i] < 90) { 
-              min_diastolic_ordinate_error = abs(omwegraph_ordinate_buffer[i] -  diastolic_ordinate_value);
-              diastolic_buffer = i;
-           }   
-        }        
-    }
+/***Function to print a benchmark result*****
+BENCHMARK_MODE prints the same CSV lines as the bench command of the host build, in CPU cycles (SystemCoreClock per second). The log buffer
+is flushed after every line, so no result is dropped while the benchmarks keep the core busy. */
+
+void print_bench_result(const BENCH_RESULT &result) {
+    log_printf("\n%s,%s,%lu,%lu,%.2f", result.stage, result.sample_type, result.size, result.calls, result.ticks_per_call);
+    log_flush();
+}
+
+/***Functions to collect latency statistics*****
+The latencies are measured for every processed sample and displayed at the end of the measurement, to check how close the acquisition runs
+to its real-time limits. */
 
-    // If pressure value found isn't reliable, set the pressure values to negative so that, we will be prompted to reconduct the test.
-    if (systolic_buffer < 0 || diastolic_buffer < 0){
-        bp_value.systolic_bloodpressure = -1;
-        bp_value.diastolic_bloodpressure = -1;
-        bp_value.diastolic_char_ratio = min_diastolic_ordinate_error;
-        bp_value.systolic_char_ratio = min_systolic_ordinate_error;
+void record_latency(LATENCY_STATS &stats, unsigned long latency_us) {
+    stats.sample_count++;
+    stats.total_us += latency_us;
+    if (latency_us > stats.max_us){
+        stats.max_us = latency_us;
     }
-    // Else load the bp values with the respective pressure values and the deviation of the found y value from the extected characteristic y value
-    else {
-        bp_value.systolic_bloodpressure = omwegraph_absicissa_buffer[systolic_buffer];
-        bp_value.diastolic_bloodpressure = omwegraph_absicissa_buffer[diastolic_buffer];
-        bp_value.diastolic_char_ratio = min_diastolic_ordinate_error;
-        bp_value.systolic_char_ratio = min_systolic_ordinate_error;        
+}
+
+void print_latency(const char *name, const LATENCY_STATS &stats) {
+    if (stats.sample_count == 0){
+        return;
     }
-    return bp_value;
+    log_printf("\n %s: mean = %lu us, max = %lu us", name, (unsigned long)(stats.total_us / stats.sample_count), stats.max_us);
 }
 
 
-/* Function check for MAP values on the go as the data is being collected 
-While the meaure_pressure funciton is running and the USER button (input from user) has been pressed the controller keeps checking for the event of a peak
-pressure change. The normalized pressure value corresponding to the peak change is the MAP value. */
+/***Functions for deferred console output*****
+At 9600 baud a single line of output keeps the UART busy for ~80 ms, so printf() is never called where it could hold up the measurement.
+log_printf() only formats the message into a local buffer and appends it to the log buffer, dropping (and counting) it if the buffer is full.
+The low priority log thread writes the buffered bytes to the console whenever no other thread needs the core. log_printf() must only be
+called from the main thread, the single producer of the log buffer. With TELEMETRY_OUTPUT_BINARY the message is sent as a TELEMETRY_TEXT record. */
 
-void MAP_calculator() {
-    double normalized_pressure = calculate_normalized_pressure();
-    if (pressure_diff > peak_pressure_diff && normalized_pressure > MIN_OMWE_THRESH && normalized_pressure < 110){        
-        peak_pressure_diff = pressure_diff;     // The peak ordinate corresponding to MAP value in OMWE
-        Mean_Arterial_Pressure = calculate_normalized_pressure();   // The MAP pressure value
+void log_printf(const char *format, ...) {
+    char line[LOG_LINE_MAX];
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vsnprintf(line, sizeof(line), format, arguments);
+    va_end(arguments);
+    if (length < 0){
+        return;
+    }
+    if (length >= (int)sizeof(line)){
+        length = sizeof(line) - 1;     // Message was truncated by vsnprintf
     }
-    
+#if TELEMETRY_OUTPUT == TELEMETRY_OUTPUT_BINARY
+    telemetry_send(TELEMETRY_TEXT, (const uint8_t *)line, length);
+#else
+    if (log_buffer.write(line, length)){
+        log_flags.set(LOG_DATA_FLAG);
+    }
+#endif
 }
 
-/**Function to auto-caliberate the base MPR pressure sensor output to 0 before starting to collect pressure values
-The MPR sensor output value before pumping the cuff is taken as the 0 reference. For pressure caliberation sample is taken for
-100 pressure readings from the MPR sensor and the MEAN VALUE is taken to be the base value reference for 0 mmHg */
-
-void auto_caliberate() {
-    unsigned long default_pressure = 0;
-    printf("\nCaliberating the sensor now!..");  
-    for(int i = 0; i < 100; i++ ){            // Sampling the 100 samples of initial pressure
-       default_pressure += measure_pressure();
-       wait_us(10000);
-    }  
-    default_pressure /= 100;
-    caliberated_MIN_OUT = default_pressure;
-    printf("\nCaliberation complete!");
+void log_loop() {
+    char chunk[64];
+    while (true) {
+        log_flags.wait_any(LOG_DATA_FLAG);
+        uint32_t length;
+        while ((length = log_buffer.read(chunk, sizeof(chunk))) > 0){
+            fwrite(chunk, 1, length, stdout);
+        }
+        fflush(stdout);
+    }
 }
 
-/*****Fuction to Calculate normalized pressure at a point
-As the sampling frequency of pressure data samples is large , an average of 5 immediate previous 
-sensor readings are taken as the actual pressure at the point. This helps to reduce the imapact of noicy data readings. For this purpose, we use a normalize buffer that works like a circular queue of depth 5,
-where the latest value replaces the oldest value and this replacement occurs in cycle.The normalized pressure is the mean of the pressure values in the queue. */
-
-double calculate_normalized_pressure(){
-  double total_count = 0.0;
-  double total_value = 0.0;
-  for (int i = 0; i < 5; i++){
-      if (buffer_queue[i] != 0.0){   // normalize_buffer is the circular queue holding the latest 5 pressure readings
-          total_value += buffer_queue[i];
-          total_count += 1.0;
-      } 
-  }
-  total_value = total_value / total_count;    // average of all the total values
-  return total_value;
+void log_flush() {
+    while (!log_buffer.empty()){
+        ThisThread::sleep_for(10ms);
+    }
 }
 
-/***Interrupt Service Routine (ISR) for checking an increased pressure release rate*****
-This ISR is attached to a Ticker, which is triggered every second to check for high release rate. i.e > 4 mmHg per sec. 
-If the release rate is found high, a flux warning flag is set true, which lights up the BLUE LED6 */
+/***Functions for the binary telemetry stream*****
+With TELEMETRY_OUTPUT_BINARY every processed sample, every new OMWE point and the final results are sent as COBS framed records with a CRC,
+through the same non-blocking log buffer as the text output. Like log_printf() they must only be called from the main thread. In text mode
+they do nothing. */
 
+void telemetry_send(uint8_t type, const uint8_t *payload, size_t length) {
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    size_t frame_length = telemetry_frame(type, payload, length, frame);
+    if (log_buffer.write((const char *)frame, frame_length)){
+        log_flags.set(LOG_DATA_FLAG);
+    }
+}
 
-void check_pressure_gradient_ISR() {
-  if (iteration > 5){
-      release_rate = calculate_normalized_pressure() - current_pressure;  // The difference between current pressure and the normalized pressure, depicts a change in release rate
-      if (release_rate > 4.0){                                       
-         flux_warning = true;     // For high release rate flux warning makes warning LED to ON
-      }
-      else {
-          flux_warning = false;   //The LED will be OFF if the release rate is normal.
-      }
-  }
-  return;
+void telemetry_sample(const PRESSURE_SAMPLE &sample, sample_t normalized_pressure) {
+#if TELEMETRY_OUTPUT == TELEMETRY_OUTPUT_BINARY
+    uint8_t payload[13];
+    uint8_t *cursor = payload;
+    telemetry_put_u32(cursor, sample.timestamp_us);
+    telemetry_put_u32(cursor, sample.pressure_data);
+    telemetry_put_u8(cursor, sample.status);
+    telemetry_put_f32(cursor, (float)normalized_pressure);
+    telemetry_send(TELEMETRY_SAMPLE, payload, cursor - payload);
+#endif
 }
 
-/***The main function that interfaces the sensor and calculates pressure readings*****
-This is the main function that interfaces the sensor using SPI protocol and receives the pressure readings. An SPI communication
-sends a set of 3 byte command sequence of 0xAA -> 0x00 -> 0x00 through MOSI at which point of time, the received data through MISO is don't care
-and is dumped into a random dummy buffer. Following this, we issue a read command as a 4 byte sequence 0xF0 -> 0x00 -> 0x00 -> 0x00 at the MOSI,
-where we get a status byte and a 3 byte output at MISO which is received in the data response buffer. Note that we use the SPI api method write() 
-in mbed to transmit and receive data. The status value of 64 indicates a valid data reading. The 3 bytes of received data is concatenated and 
-converted into actual pressure reading in mmHG using the conversion formula */
-
-long measure_pressure () { 
-    if (dataread_push_button){          // read data from the sensor is not recorded until the record_push_button is i pressed to neglet unwanted data
-        active_recordflag = true;
-    }
-    active_flag = active_recordflag;
-    long pressure_data = 0;
-    double normalized_pressure = 0;
-    char read_command_buffer[4] = {0xF0, 0x00, 0x00, 0x00};   // Buffer containing the read command bytes
-    char write_command_buffer[3] = {0xAA, 0x00, 0x00};        // Buffer containing the write command bytes.
-    char dummy_response_buffer[4] = {0, 0, 0, 0};             // Dummy response buffer to hold garbage values from MISO 
-    char data_receive_buffer[4] = {0, 0, 0, 0};  
-    char status;   
-
-    double pressure_value;
-    double scaler = (PRESSURE_MAX - PRESSURE_MIN) / (OUTPUT_MAX - OUTPUT_MIN); // Scaler value to convert 24 bit MPR data into actual pressure value 
-     cs = 0;          // SS pin set to '0' to activate slave select before SPI communication starts 
-     spi_comm.write(write_command_buffer, 3, dummy_response_buffer, 3);   // Initiate a command to read pressure
-     cs = 1;          // Set the SS pin to end communication
-     wait_us(10000);     // 10ms wait time for MPR sensor to sample and calculate pressure
-
-     cs = 0;          // By reset SS pin we start the SPI communication again 
-     spi_comm.write(read_command_buffer, 4, data_receive_buffer, 4);   // enable read command and receive data into data_receive_buffer
-     pressure_data = pressure_data | (long)data_receive_buffer[3] | (long)data_receive_buffer[2] << 8 | (long)data_receive_buffer[1] << 16; // Concatenate the 3 data bytes
-     status = data_receive_buffer[0];    // Status bit!
-     pressure_value = scaler*(double)(pressure_data - caliberated_MIN_OUT);  // Conversion of 24-bit data to pressure reading in mmHg
-     current_pressure = pressure_value;
-    normalized_pressure = calculate_normalized_pressure();
-    if (pressure_display_timer.read() > 1){              // to display the data on screen
-        printf("\n Recorded pressure = %lf. Pressure release rate = %lf mmHg per second ",normalized_pressure, release_rate);
-        pressure_display_timer.reset();
-    }
-     if (active_recordflag && abs(current_pressure - normalized_pressure) < 12.0) {   // If the button is pressed and data read is viable, record the readings
-         pressure_diff = abs(current_pressure - normalized_pressure);   // Difference pressure is the change in the peak of current to normalised pressure
-        if (normalized_pressure > MIN_OMWE_THRESH && normalized_pressure < MAX_OMWE_THRESH){
-            if(pressure_diff < previous_pressure_diff){   // Condition to check if the graph passed a maxima that has to be stored
-                if (omwetime_buffer_pointer > 0){
-                  if (pulse_count_timer.read_ms() - omwe_buffer_time[omwetime_buffer_pointer - 1] > 500.0){  // Bandpass filter for pulse time minute measurement
-                    omwe_buffer_time[omwetime_buffer_pointer++] = pulse_count_timer.read_ms();
-                  }  
-                }   
-                else {
-                   omwe_buffer_time[omwetime_buffer_pointer++] = pulse_count_timer.read_ms(); 
-                }  
-                omwegraph_ordinate_buffer[omwebuffer_pointer] = previous_pressure_diff;
-                omwegraph_absicissa_buffer[omwebuffer_pointer++] = normalized_pressure;
-            }
-        } 
-        previous_pressure_diff = pressure_diff;
-     }      
-    buffer_queue[iteration++ % 5] = pressure_value;  // Updating the buffer_queue (by circular queue manner)
-    MAP_calculator();              // MAP calculater is called to check, if the passed maxima is the absolute maxima in the OMWE for which we have to store as MAP value
-     if (normalized_pressure > 200.0){    // At the upper limit of 200.0 mmHg pressure, a motification is send to release the pressure in the pump and record data for OMWE
-          max_pressure = 1;  
-         }      // If red LED is ON, It is indicating Maximum pressure 
-     cs = 1;  
-     if (active_flag && normalized_pressure < 5.0){   // if the pressure is dropped less than 5 mmHg andIf the active flag used for rate measurement is active and , we can now stop pressure measurement
-         end_record = true;
-     } 
-     return pressure_data;
-}
\ No newline at end of file
+void telemetry_omwe_point(unsigned long time_ms, sample_t pressure, sample_t amplitude) {
+#if TELEMETRY_OUTPUT == TELEMETRY_OUTPUT_BINARY
+    uint8_t payload[12];
+    uint8_t *cursor = payload;
+    telemetry_put_u32(cursor, time_ms);
+    telemetry_put_f32(cursor, (float)pressure);
+    telemetry_put_f32(cursor, (float)amplitude);
+    telemetry_send(TELEMETRY_OMWE_POINT, payload, cursor - payload);
+#endif
+}
+
+void telemetry_results(const BP_PARAMETER &bp, const PULSE_READING &pulse) {
+#if TELEMETRY_OUTPUT == TELEMETRY_OUTPUT_BINARY
+    uint8_t payload[20];
+    uint8_t *cursor = payload;
+    telemetry_put_f32(cursor, (float)bp.systolic_bloodpressure);
+    telemetry_put_f32(cursor, (float)bp.diastolic_bloodpressure);
+    telemetry_put_f32(cursor, (float)measurement.mean_arterial_pressure());
+    telemetry_put_f32(cursor, (float)bp.systolic_char_ratio);
+    telemetry_put_f32(cursor, (float)bp.diastolic_char_ratio);
+    telemetry_send(TELEMETRY_BP_RESULT, payload, cursor - payload);
+    cursor = payload;
+    telemetry_put_f32(cursor, (float)pulse.pulse_value);
+    telemetry_put_u32(cursor, pulse.pulse_data_count);
+    telemetry_send(TELEMETRY_PULSE, payload, cursor - payload);
+#endif
+}
@@ -0,0 +1,145 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       mpr_acquisition.cpp
+* Description: Reads raw pressure samples from the MPR sensor. The bus, the clock and the EOC pin are accessed through bp_hal.h, so the same
+* code drives the real sensor on the target and the simulated sensor of the host build.
+*/
+
+#include "mpr_acquisition.h"
+#include "bp_hal.h"
+
+bool conversion_pending = false;     // A pipelined conversion was started and its output has not been read yet
+bool conversion_sent = false;        // The command of the pending pipelined conversion reached the sensor
+unsigned long conversion_started_us = 0;   // Start time of the pending pipelined conversion
+SAMPLE_RECORDER sample_recorder = 0;       // Optional recorder of the raw samples (session recording)
+
+/***The main function that interfaces the sensor and reads pressure samples*****
+This is the main function that interfaces the sensor using SPI protocol and receives the pressure readings. An SPI communication
+sends a set of 3 byte command sequence of 0xAA -> 0x00 -> 0x00 through MOSI at which point of time, the received data through MISO is don't care
+and is dumped into a random dummy buffer. After the conversion finished (see wait_for_conversion()), we issue a read command as a 4 byte sequence
+0xF0 -> 0x00 -> 0x00 -> 0x00 at the MOSI, where we get a status byte and a 3 byte output at MISO which is received in the data response buffer.
+Note that we use the SPI api method write() in mbed to transmit and receive data. The status value of 64 indicates a valid data reading. The 3 bytes
+of received data is concatenated and returned as a raw sample, the conversion into actual pressure reading in mmHg is done by process_pressure_sample() */
+
+PRESSURE_SAMPLE measure_pressure () { 
+    unsigned long started_us = hal_now_us();
+    bool sent = start_conversion();
+    wait_for_conversion();
+    PRESSURE_SAMPLE sample = read_conversion(started_us);
+    if (!sent){
+        sample.status |= MPR_STATUS_TRANSFER_FAILED;     // The output is that of an earlier conversion
+    }
+    if (sample_recorder && !(sample.status & MPR_STATUS_TRANSFER_FAILED)){
+        sample_recorder(sample);
+    }
+    return sample;
+}
+
+/***Function to read pressure samples with pipelined conversions*****
+Instead of command -> wait -> read on every tick, the output of the conversion started on the previous tick is read and the next conversion is
+started right away in the same bus window. The sensor then converts while the CPU sleeps or processes the previous sample, so the only time spent
+on the bus per tick is the two SPI transfers and the sample rate can approach the maximum conversion rate of the sensor. The cost is one sampling
+period of extra latency, which is reported as the conversion latency. If a tick arrives before the conversion finished (busy flag still set),
+the read is repeated after waiting for the end of conversion. */
+
+PRESSURE_SAMPLE measure_pressure_pipelined() {
+    PRESSURE_SAMPLE sample;
+    if (!conversion_pending){           // First sample, nothing is converting yet
+        conversion_started_us = hal_now_us();
+        conversion_sent = start_conversion();
+        wait_for_conversion();
+    }
+    sample = read_conversion(conversion_started_us);
+    if (sample.status & MPR_STATUS_BUSY){
+        wait_for_conversion();
+        sample = read_conversion(conversion_started_us);
+    }
+    if (!conversion_sent){
+        sample.status |= MPR_STATUS_TRANSFER_FAILED;
+    }
+    conversion_started_us = hal_now_us();
+    conversion_sent = start_conversion();
+    conversion_pending = true;
+    if (sample_recorder && !(sample.status & MPR_STATUS_TRANSFER_FAILED)){
+        sample_recorder(sample);
+    }
+    return sample;
+}
+
+void reset_acquisition() {
+    conversion_pending = false;
+}
+
+void set_sample_recorder(SAMPLE_RECORDER recorder) {
+    sample_recorder = recorder;
+}
+
+bool start_conversion() {
+    char write_command_buffer[3] = {(char)MPR_CMD_START_CONVERSION, 0x00, 0x00};        // Buffer containing the write command bytes.
+    char dummy_response_buffer[3] = {0, 0, 0};             // Dummy response buffer to hold garbage values from MISO 
+#if MPR_ACQUISITION_MODE == MPR_WAIT_EOC
+    hal_eoc_arm();     // Forget an edge of an earlier conversion before starting a new one
+#endif
+     return mpr_spi_exchange(write_command_buffer, dummy_response_buffer, 3);   // Initiate a command to read pressure
+}
+
+/***Function to wait for the end of an MPR conversion*****
+MPR_WAIT_FIXED waits the 10 ms worst case conversion time. MPR_WAIT_EOC sleeps until the EOC interrupt fires and MPR_WAIT_BUSY_POLL reads the status byte
+every MPR_POLL_BACKOFF_US until the busy flag clears. Both return as soon as the output is ready (typically after ~5 ms), so about half of the fixed
+wait is given back to the sampling budget. If the sensor does not signal the end of conversion, both give up after MPR_CONVERSION_TIMEOUT_US. */
+
+void wait_for_conversion() {
+#if MPR_ACQUISITION_MODE == MPR_WAIT_EOC
+    hal_eoc_wait(MPR_CONVERSION_TIMEOUT_US);
+#elif MPR_ACQUISITION_MODE == MPR_WAIT_BUSY_POLL
+    char poll_command = (char)MPR_CMD_READ;
+    char status = MPR_STATUS_BUSY;
+    for (int waited_us = 0; waited_us < MPR_CONVERSION_TIMEOUT_US; waited_us += MPR_POLL_BACKOFF_US){
+        hal_wait_us(MPR_POLL_BACKOFF_US);
+        if (mpr_spi_exchange(&poll_command, &status, 1) && !(status & MPR_STATUS_BUSY)){     // Only the status byte is clocked out
+            break;
+        }
+    }
+#else
+     hal_wait_us(MPR_CONVERSION_TIMEOUT_US);     // 10ms wait time for MPR sensor to sample and calculate pressure
+#endif
+}
+
+PRESSURE_SAMPLE read_conversion(unsigned long started_us) {
+    PRESSURE_SAMPLE sample;
+    long pressure_data = 0;
+    char read_command_buffer[4] = {(char)MPR_CMD_READ, 0x00, 0x00, 0x00};   // Buffer containing the read command bytes
+    char data_receive_buffer[4] = {0, 0, 0, 0};  
+     bool received = mpr_spi_exchange(read_command_buffer, data_receive_buffer, 4);   // enable read command and receive data into data_receive_buffer
+     pressure_data = pressure_data | (long)(unsigned char)data_receive_buffer[3] | (long)(unsigned char)data_receive_buffer[2] << 8 | (long)(unsigned char)data_receive_buffer[1] << 16; // Concatenate the 3 data bytes
+     sample.timestamp_us = started_us;
+     sample.conversion_us = hal_now_us() - started_us;
+     sample.pressure_data = pressure_data;
+     sample.status = data_receive_buffer[0];    // Status bit!
+     if (!received){
+         sample.status |= MPR_STATUS_TRANSFER_FAILED;
+     }
+     return sample;
+}
+
+/**Function to auto-caliberate the base MPR pressure sensor output to 0 before starting to collect pressure values
+The MPR sensor output value before pumping the cuff is taken as the 0 reference. For pressure caliberation sample is taken for
+CALIBRATION_SAMPLES (100) pressure readings from the MPR sensor and the MEAN VALUE is taken to be the base value reference for 0 mmHg, which is returned.
+Readings whose SPI exchange failed are not counted, after twice as many attempts the mean of the readings taken so far is returned. */
+
+long auto_caliberate() {
+    unsigned long default_pressure = 0;
+    int readings = 0;
+    for(int attempt = 0; readings < CALIBRATION_SAMPLES && attempt < 2 * CALIBRATION_SAMPLES; attempt++ ){    // Sampling the 100 samples of initial pressure
+       PRESSURE_SAMPLE sample = measure_pressure();
+       if (!(sample.status & MPR_STATUS_TRANSFER_FAILED)){
+           default_pressure += sample.pressure_data;
+           readings++;
+       }
+       hal_wait_us(10000);
+    }  
+    if (readings > 0){
+        default_pressure /= readings;
+    }
+    return default_pressure;
+}
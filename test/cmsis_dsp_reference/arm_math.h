@@ -0,0 +1,46 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       arm_math.h
+* Description: Reference stand-in of the part of CMSIS-DSP that biquad_filter.h uses, for the native_cmsis_dsp environment of
+* platformio.ini: the types and arm_biquad_cascade_df1_f32() with the signature of CMSIS-DSP 1.5 (the input is float32_t *) and the
+* direct form I recursion its documentation specifies. It lets the host build compile and test the BP_USE_CMSIS_DSP=1 code path; it is
+* not a replacement of the optimized library on the target.
+*/
+
+#ifndef ARM_MATH_H
+#define ARM_MATH_H
+
+#include <stdint.h>
+
+typedef float float32_t;
+
+typedef struct {
+    uint32_t numStages;             // Number of second order sections
+    float32_t *pState;              // {x[n-1], x[n-2], y[n-1], y[n-2]} per section
+    float32_t *pCoeffs;             // {b0, b1, b2, a1, a2} per section
+} arm_biquad_casd_df1_inst_f32;
+
+static inline void arm_biquad_cascade_df1_f32(const arm_biquad_casd_df1_inst_f32 *S, float32_t *pSrc, float32_t *pDst, uint32_t blockSize) {
+    float32_t *input = pSrc;
+    for (uint32_t stage = 0; stage < S->numStages; stage++){
+        const float32_t *section = S->pCoeffs + 5 * stage;
+        float32_t *history = S->pState + 4 * stage;
+        float32_t x1 = history[0], x2 = history[1], y1 = history[2], y2 = history[3];
+        for (uint32_t n = 0; n < blockSize; n++){
+            float32_t x0 = input[n];
+            float32_t y0 = section[0] * x0 + section[1] * x1 + section[2] * x2 + section[3] * y1 + section[4] * y2;
+            x2 = x1;
+            x1 = x0;
+            y2 = y1;
+            y1 = y0;
+            pDst[n] = y0;
+        }
+        history[0] = x1;
+        history[1] = x2;
+        history[2] = y1;
+        history[3] = y2;
+        input = pDst;
+    }
+}
+
+#endif
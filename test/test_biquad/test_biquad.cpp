@@ -0,0 +1,100 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       test_biquad.cpp
+* Description: Unit tests of the biquad cascades (biquad_filter.h) with the sections of the cuff pressure and oscillation filters: the
+* start without a transient, the same output for any block size, and single precision against the double cascade on a deflation with a
+* pulse. Run with pio test -e native, and with pio test -e native_cmsis_dsp for the BP_USE_CMSIS_DSP=1 kernel of the float cascade.
+*/
+
+#include <unity.h>
+#include <math.h>
+#include "biquad_filter.h"
+#include "bp_config.h"
+
+#define BIQUAD_TEST_SAMPLES 2000        // 40 s at 50 Hz, most of a deflation
+#define BIQUAD_FLOAT_TOLERANCE 1e-2     // mmHg, the float cuff pressure of the synthetic deflations stays within 3.3e-3 (sample_types.h)
+
+static const BIQUAD_SECTION cuff_sections[2] = {biquad_lowpass(CUFF_LOWPASS_HZ, 0.5412, SAMPLE_RATE_HZ),
+                                                biquad_lowpass(CUFF_LOWPASS_HZ, 1.3066, SAMPLE_RATE_HZ)};
+static const BIQUAD_SECTION oscillation_sections[2] = {biquad_highpass(OSCILLATION_LOW_HZ, 0.7071, SAMPLE_RATE_HZ),
+                                                       biquad_lowpass(OSCILLATION_HIGH_HZ, 0.7071, SAMPLE_RATE_HZ)};
+
+// Cuff pressure falling from 160 mmHg at 3 mmHg/s with a 1 mmHg pulse at 72 bpm
+static double deflation(int sample) {
+    double time_s = (double)sample / SAMPLE_RATE_HZ;
+    return 160.0 - 3.0 * time_s + sin(2.0 * M_PI * 1.2 * time_s);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_reset_starts_in_steady_state(void) {
+    BiquadCascade<float, 2> cuff, oscillation;
+    cuff.configure(cuff_sections);
+    oscillation.configure(oscillation_sections);
+    cuff.reset(150.0f);
+    oscillation.reset(150.0f);
+    for (int i = 0; i < 100; i++){
+        float input = 150.0f, pressure, pulse;
+        cuff.process(&input, &pressure, 1);
+        oscillation.process(&input, &pulse, 1);
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, 150.0f, pressure);
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f, pulse);
+    }
+}
+
+void test_block_size_does_not_change_output(void) {
+    static float input[BIQUAD_TEST_SAMPLES], single[BIQUAD_TEST_SAMPLES], blocks[BIQUAD_TEST_SAMPLES];
+    BiquadCascade<float, 2> by_sample, by_block;
+    by_sample.configure(cuff_sections);
+    by_block.configure(cuff_sections);
+    for (int i = 0; i < BIQUAD_TEST_SAMPLES; i++){
+        input[i] = (float)deflation(i);
+    }
+    by_sample.reset(input[0]);
+    by_block.reset(input[0]);
+    for (int i = 0; i < BIQUAD_TEST_SAMPLES; i++){
+        by_sample.process(&input[i], &single[i], 1);
+    }
+    for (int i = 0, block = 1; i < BIQUAD_TEST_SAMPLES; i += block, block = block % 7 + 1){
+        int count = i + block <= BIQUAD_TEST_SAMPLES ? block : BIQUAD_TEST_SAMPLES - i;
+        by_block.process(&input[i], &blocks[i], count);
+    }
+    for (int i = 0; i < BIQUAD_TEST_SAMPLES; i++){
+        TEST_ASSERT_EQUAL_FLOAT(single[i], blocks[i]);
+    }
+}
+
+void test_float_matches_double(void) {
+    BiquadCascade<float, 2> cuff, oscillation;
+    BiquadCascade<double, 2> cuff_reference, oscillation_reference;
+    cuff.configure(cuff_sections);
+    oscillation.configure(oscillation_sections);
+    cuff_reference.configure(cuff_sections);
+    oscillation_reference.configure(oscillation_sections);
+    cuff.reset((float)deflation(0));
+    oscillation.reset((float)deflation(0));
+    cuff_reference.reset(deflation(0));
+    oscillation_reference.reset(deflation(0));
+    for (int i = 0; i < BIQUAD_TEST_SAMPLES; i++){
+        float input = (float)deflation(i), pressure, pulse;
+        double reference_input = deflation(i), reference_pressure, reference_pulse;
+        cuff.process(&input, &pressure, 1);
+        oscillation.process(&input, &pulse, 1);
+        cuff_reference.process(&reference_input, &reference_pressure, 1);
+        oscillation_reference.process(&reference_input, &reference_pulse, 1);
+        TEST_ASSERT_DOUBLE_WITHIN(BIQUAD_FLOAT_TOLERANCE, reference_pressure, pressure);
+        TEST_ASSERT_DOUBLE_WITHIN(BIQUAD_FLOAT_TOLERANCE, reference_pulse, pulse);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_reset_starts_in_steady_state);
+    RUN_TEST(test_block_size_does_not_change_output);
+    RUN_TEST(test_float_matches_double);
+    return UNITY_END();
+}
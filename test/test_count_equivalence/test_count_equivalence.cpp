@@ -0,0 +1,91 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       test_count_equivalence.cpp
+* Description: Equivalence of the count pipeline (BP_SAMPLE_TYPE_COUNTS) and the double pipeline on synthetic recordings. Both sample types
+* are instantiated in every build, so the test does not depend on the sample type of the build. Recording N uses the seed N + 1 and
+* spreads the systolic and diastolic pressure and the heart rate around the waveform defaults, with a little sensor noise and beat to beat
+* variability; the 60 recordings cover every combination of the spreads.
+*
+* The pipelines can not be bit exact: the filters round to a count/16 instead of to double. The completion and the reliability of the
+* result have to be the same, and SBP, DBP, MAP and the release rate have to agree within EQUIVALENCE_TOLERANCE. When the two largest
+* beats of a recording tie within that rounding, the count pipeline can take the other one as MAP and its readings move by mmHg; none of
+* these recordings has such a tie, so a failure here is a real difference of the pipelines. Run with pio test -e native, which builds src/
+* for the session analysis and the waveform generator.
+*/
+
+#include <unity.h>
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include "session_analysis.h"
+#include "waveform_generator.h"
+
+#define EQUIVALENCE_RECORDINGS 60       // lcm of the spreads of the systolic pressure, the diastolic pressure and the heart rate
+#define EQUIVALENCE_TOLERANCE 0.02      // mmHg, the largest deviation of these recordings is 0.015 (systolic pressure)
+
+// Session of a synthetic waveform sampled at SAMPLE_RATE_HZ, the USER button is pressed when the release starts
+static void equivalence_session(const WAVEFORM &waveform, SESSION &session) {
+    session.sample_rate_hz = SAMPLE_RATE_HZ;
+    session.samples.clear();
+    session.events.clear();
+    unsigned long end_us = (unsigned long)((waveform.end_s + 1.0) * 1e6);
+    unsigned long release_us = (unsigned long)(waveform.deflate_start_s * 1e6);
+    for (unsigned long n = 0; n * 1000000ULL / SAMPLE_RATE_HZ < end_us; n++){
+        unsigned long time_us = (unsigned long)(n * 1000000ULL / SAMPLE_RATE_HZ);
+        if (session.events.empty() && time_us >= release_us){
+            SESSION_ENTRY event = {time_us, SESSION_EVENT_RECORD_START, SESSION_EVENT};
+            session.events.push_back(event);
+        }
+        SESSION_ENTRY sample = {time_us, waveform_counts(waveform, time_us), MPR_STATUS_POWERED};
+        session.samples.push_back(sample);
+    }
+}
+
+static void equivalence_recording(unsigned long recording, SESSION &session) {
+    WAVEFORM_PARAMETERS base;
+    waveform_default_parameters(base);
+    WAVEFORM_PARAMETERS parameters = base;
+    parameters.noise = 0.02;
+    parameters.hrv = 0.03;
+    parameters.seed = recording + 1;
+    parameters.systolic = base.systolic + (double)(recording % 5) * 8.0 - 16.0;
+    parameters.diastolic = base.diastolic + (double)(recording % 3) * 6.0 - 6.0;
+    parameters.map = parameters.diastolic + (base.map - base.diastolic) * (parameters.systolic - parameters.diastolic) /
+                                            (base.systolic - base.diastolic);
+    parameters.heart_rate = base.heart_rate + (double)(recording % 4) * 8.0 - 12.0;
+    WAVEFORM waveform;
+    waveform_init(waveform, parameters);
+    equivalence_session(waveform, session);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_counts_match_double(void) {
+    std::unique_ptr<MeasurementSession<double> > reference(new MeasurementSession<double>());
+    std::unique_ptr<MeasurementSession<count_t> > counts(new MeasurementSession<count_t>());
+    for (unsigned long recording = 0; recording < EQUIVALENCE_RECORDINGS; recording++){
+        SESSION session;
+        equivalence_recording(recording, session);
+        SESSION_RESULT expected = analyze_session(session, *reference);
+        SESSION_RESULT result = analyze_session(session, *counts);
+        char message[64];
+        snprintf(message, sizeof(message), "recording %lu", recording);
+        TEST_ASSERT_TRUE_MESSAGE(expected.complete, message);
+        TEST_ASSERT_EQUAL_MESSAGE(expected.complete, result.complete, message);
+        TEST_ASSERT_EQUAL_MESSAGE(expected.bp.systolic_bloodpressure < 0, result.bp.systolic_bloodpressure < 0, message);
+        TEST_ASSERT_DOUBLE_WITHIN_MESSAGE(EQUIVALENCE_TOLERANCE, expected.bp.systolic_bloodpressure, result.bp.systolic_bloodpressure, message);
+        TEST_ASSERT_DOUBLE_WITHIN_MESSAGE(EQUIVALENCE_TOLERANCE, expected.bp.diastolic_bloodpressure, result.bp.diastolic_bloodpressure, message);
+        TEST_ASSERT_DOUBLE_WITHIN_MESSAGE(EQUIVALENCE_TOLERANCE, expected.mean_arterial_pressure, result.mean_arterial_pressure, message);
+        TEST_ASSERT_DOUBLE_WITHIN_MESSAGE(EQUIVALENCE_TOLERANCE, reference->release_rate(), (double)counts->release_rate(), message);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_counts_match_double);
+    return UNITY_END();
+}
@@ -0,0 +1,85 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       test_moving_average.cpp
+* Description: Unit tests of the moving average of the normalized pressure (moving_average.h): the mean before and after the window is
+* full, and the resync of the running sum at every wrap of the window, which drops the rounding error of floating point samples. Run with
+* pio test -e native.
+*/
+
+#include <unity.h>
+#include "moving_average.h"
+#include "sample_types.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_mean_of_partial_window(void) {
+    MovingAverage<double, 4> average;
+    TEST_ASSERT_EQUAL_FLOAT(0.0, average.value());
+    average.push(2.0);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-12, 2.0, average.value());
+    average.push(4.0);
+    average.push(6.0);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-12, 4.0, average.value());
+    TEST_ASSERT_EQUAL_INT(3, average.count());
+    TEST_ASSERT_FALSE(average.full());
+}
+
+void test_window_slides(void) {
+    MovingAverage<double, 4> average;
+    for (int i = 1; i <= 10; i++){
+        average.push((double)i);
+        if (i >= 4){
+            TEST_ASSERT_TRUE(average.full());
+            TEST_ASSERT_DOUBLE_WITHIN(1e-12, i - 1.5, average.value());   // Mean of i - 3 .. i
+        }
+    }
+    average.reset();
+    TEST_ASSERT_EQUAL_INT(0, average.count());
+    average.push(7.0);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-12, 7.0, average.value());
+}
+
+// A large sample leaves the float sum with the rounding error of its magnitude (1/16 at 1e6). Once the window wrapped without it, the
+// mean is that of the samples in the window again.
+void test_resync_drops_rounding_error(void) {
+    MovingAverage<float, 5> average;
+    average.push(1.0e6f);
+    for (int i = 0; i < 4; i++){
+        average.push(0.3f);
+    }
+    for (int lap = 0; lap < 3; lap++){
+        for (int i = 0; i < 5; i++){
+            average.push(0.3f);
+            if (lap > 0){
+                TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.3f, average.value());
+            }
+        }
+    }
+}
+
+void test_fixed_point_mean_is_exact(void) {
+    MovingAverage<q16_16_t, 8> average;
+    int32_t sum = 0;
+    for (int i = 0; i < 40; i++){
+        q16_16_t sample = q16_16_t::from_raw(1000003 * (i % 7) - 2500000);
+        average.push(sample);
+        sum += sample.raw();
+        if (i >= 8){
+            sum -= (1000003 * ((i - 8) % 7) - 2500000);
+        }
+        TEST_ASSERT_EQUAL_INT32(sum / average.count(), average.value().raw());
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_mean_of_partial_window);
+    RUN_TEST(test_window_slides);
+    RUN_TEST(test_resync_drops_rounding_error);
+    RUN_TEST(test_fixed_point_mean_is_exact);
+    return UNITY_END();
+}
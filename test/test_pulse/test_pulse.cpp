@@ -0,0 +1,78 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       test_pulse.cpp
+* Description: Regression test of the pulse: synthetic deflations at slow, normal and fast heart rates, with sensor noise and beat to beat
+* variability, have to report their heart rate. The pulse is taken from the beats of the oscillation, so it must not depend on how many
+* OMWE graph points a beat produces. Run with pio test -e native, which builds src/ for the session analysis and the waveform generator.
+*/
+
+#include <unity.h>
+#include <memory>
+#include "session_analysis.h"
+#include "waveform_generator.h"
+
+#define PULSE_TOLERANCE_BPM 1.5         // The beat to beat variability makes the mean interval of a recording differ from the heart rate
+
+// Session of a synthetic waveform sampled at SAMPLE_RATE_HZ, the USER button is pressed when the release starts
+static void pulse_session(double heart_rate, unsigned long seed, SESSION &session) {
+    WAVEFORM_PARAMETERS parameters;
+    waveform_default_parameters(parameters);
+    parameters.heart_rate = heart_rate;
+    parameters.noise = 0.05;
+    parameters.hrv = 0.03;
+    parameters.seed = seed;
+    WAVEFORM waveform;
+    waveform_init(waveform, parameters);
+    session.sample_rate_hz = SAMPLE_RATE_HZ;
+    session.samples.clear();
+    session.events.clear();
+    unsigned long end_us = (unsigned long)((waveform.end_s + 1.0) * 1e6);
+    unsigned long release_us = (unsigned long)(waveform.deflate_start_s * 1e6);
+    for (unsigned long n = 0; n * 1000000ULL / SAMPLE_RATE_HZ < end_us; n++){
+        unsigned long time_us = (unsigned long)(n * 1000000ULL / SAMPLE_RATE_HZ);
+        if (session.events.empty() && time_us >= release_us){
+            SESSION_ENTRY event = {time_us, SESSION_EVENT_RECORD_START, SESSION_EVENT};
+            session.events.push_back(event);
+        }
+        SESSION_ENTRY sample = {time_us, waveform_counts(waveform, time_us), MPR_STATUS_POWERED};
+        session.samples.push_back(sample);
+    }
+}
+
+static void check_pulse(double heart_rate) {
+    std::unique_ptr<MeasurementSession<sample_t> > measurement(new MeasurementSession<sample_t>());
+    for (unsigned long seed = 1; seed <= 3; seed++){
+        SESSION session;
+        pulse_session(heart_rate, seed, session);
+        SESSION_RESULT result = analyze_session(session, *measurement);
+        TEST_ASSERT_TRUE(result.complete);
+        TEST_ASSERT_TRUE(result.pulse.pulse_data_count >= 5);
+        TEST_ASSERT_DOUBLE_WITHIN(PULSE_TOLERANCE_BPM, heart_rate, result.pulse.pulse_value);
+    }
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_pulse_at_50_bpm(void) {
+    check_pulse(50.0);
+}
+
+void test_pulse_at_72_bpm(void) {
+    check_pulse(72.0);
+}
+
+void test_pulse_at_110_bpm(void) {
+    check_pulse(110.0);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_pulse_at_50_bpm);
+    RUN_TEST(test_pulse_at_72_bpm);
+    RUN_TEST(test_pulse_at_110_bpm);
+    return UNITY_END();
+}
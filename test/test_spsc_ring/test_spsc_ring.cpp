@@ -0,0 +1,98 @@
+/*
+* Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+* File:       test_spsc_ring.cpp
+* Description: Unit tests of the sample ring (spsc_ring.h): empty and full ring, overruns, and items that wrap around the end of the storage,
+* one at a time and with the batch pop of the processing loop. Run with pio test -e native.
+*/
+
+#include <unity.h>
+#include "spsc_ring.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_empty_ring_pops_nothing(void) {
+    SpscRing<int, 4> ring;
+    int item = -1;
+    int items[4];
+    TEST_ASSERT_TRUE(ring.empty());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.size());
+    TEST_ASSERT_FALSE(ring.pop(item));
+    TEST_ASSERT_EQUAL_INT(-1, item);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.pop(items, 4));
+}
+
+void test_full_ring_drops_and_counts(void) {
+    SpscRing<int, 4> ring;
+    for (int i = 0; i < 4; i++){
+        TEST_ASSERT_TRUE(ring.push(i));
+    }
+    TEST_ASSERT_EQUAL_UINT32(4, ring.size());
+    TEST_ASSERT_FALSE(ring.push(4));
+    TEST_ASSERT_FALSE(ring.push(5));
+    TEST_ASSERT_EQUAL_UINT32(2, ring.overruns());
+    TEST_ASSERT_EQUAL_UINT32(4, ring.size());
+    int item;
+    for (int i = 0; i < 4; i++){                 // The items already in the ring are kept, the new ones were dropped
+        TEST_ASSERT_TRUE(ring.pop(item));
+        TEST_ASSERT_EQUAL_INT(i, item);
+    }
+    TEST_ASSERT_TRUE(ring.empty());
+    TEST_ASSERT_TRUE(ring.push(6));               // A slot is free again
+    TEST_ASSERT_EQUAL_UINT32(2, ring.overruns());
+}
+
+void test_items_wrap_in_order(void) {
+    SpscRing<int, 4> ring;
+    int next_push = 0, next_pop = 0, item;
+    for (int lap = 0; lap < 10; lap++){          // Three in, two out: the indices move around the storage and the ring fills up
+        for (int i = 0; i < 3; i++){
+            if (ring.push(next_push)){
+                next_push++;
+            }
+        }
+        for (int i = 0; i < 2; i++){
+            TEST_ASSERT_TRUE(ring.pop(item));
+            TEST_ASSERT_EQUAL_INT(next_pop++, item);
+        }
+    }
+    while (ring.pop(item)){
+        TEST_ASSERT_EQUAL_INT(next_pop++, item);
+    }
+    TEST_ASSERT_EQUAL_INT(next_push, next_pop);
+    TEST_ASSERT_EQUAL_UINT32(30 - next_push, ring.overruns());
+}
+
+void test_batch_pop_wraps(void) {
+    SpscRing<int, 8> ring;
+    int items[8];
+    for (int i = 0; i < 6; i++){
+        ring.push(i);
+    }
+    TEST_ASSERT_EQUAL_UINT32(6, ring.pop(items, 8));       // Tail at slot 6
+    for (int i = 6; i < 13; i++){                         // Slots 6, 7, 0 .. 4
+        TEST_ASSERT_TRUE(ring.push(i));
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, ring.pop(items, 3));       // Fewer than waiting
+    for (int i = 0; i < 3; i++){
+        TEST_ASSERT_EQUAL_INT(6 + i, items[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(4, ring.pop(items, 8));       // More than waiting, across the end of the storage
+    for (int i = 0; i < 4; i++){
+        TEST_ASSERT_EQUAL_INT(9 + i, items[i]);
+    }
+    TEST_ASSERT_TRUE(ring.empty());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.overruns());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_ring_pops_nothing);
+    RUN_TEST(test_full_ring_drops_and_counts);
+    RUN_TEST(test_items_wrap_in_order);
+    RUN_TEST(test_batch_pop_wraps);
+    return UNITY_END();
+}
@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""
+Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+File:       bench_compare.py
+Description: Compares two benchmark result files (CSV output of the host bench command or of a BENCHMARK_MODE firmware) and prints the
+change of every stage, so the cost of a commit can be read at a glance.
+
+Usage:
+    bench_compare.py before.csv after.csv [--threshold 5]
+"""
+
+import argparse
+import csv
+import sys
+
+
+def load(path):
+    with open(path, newline="") as handle:
+        reader = csv.reader(handle)
+        header = next(reader)
+        results = {}
+        for row in reader:
+            if len(row) == len(header):
+                results[tuple(row[:3])] = float(row[4])
+        return header[4], results
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two benchmark result files")
+    parser.add_argument("before")
+    parser.add_argument("after")
+    parser.add_argument("--threshold", type=float, default=5.0, help="mark changes larger than this many percent")
+    args = parser.parse_args()
+
+    unit_before, before = load(args.before)
+    unit_after, after = load(args.after)
+    if unit_before != unit_after:
+        sys.exit("the files use different units (%s, %s)" % (unit_before, unit_after))
+    print("%-18s %-8s %6s %14s %14s %9s" % ("stage", "type", "size", "before", "after", "change"))
+    for key in sorted(set(before) | set(after), key=lambda key: (key[0], key[1], int(key[2]))):
+        old, new = before.get(key), after.get(key)
+        if old is None or new is None:
+            change = "added" if old is None else "removed"
+        else:
+            percent = (new - old) / old * 100.0 if old else 0.0
+            change = "%+8.1f%%" % percent + (" *" if abs(percent) > args.threshold else "")
+        print("%-18s %-8s %6s %14s %14s %9s" % (key + (
+            "-" if old is None else "%.2f" % old, "-" if new is None else "%.2f" % new, change)))
+
+
+if __name__ == "__main__":
+    main()
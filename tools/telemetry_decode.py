@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""
+Project:    Embedded Challenge : Semi automated blood pressure/heart rate measuring device
+File:       telemetry_decode.py
+Description: Host side decoder of the binary telemetry stream (TELEMETRY_OUTPUT_BINARY, see include/telemetry.h). Reads a recorded stream
+from a file (or stdin) or a live serial port, checks the COBS framing and the CRC of every record and writes one CSV file per record type.
+A session image sent by a SESSION_RECORDING build is reassembled into session.bps, which the host build replays (program replay session.bps).
+
+Usage:
+    telemetry_decode.py session.bin --out-dir session/
+    telemetry_decode.py --serial /dev/ttyACM0 --baud 115200 --out-dir session/ --raw session.bin
+"""
+
+import argparse
+import csv
+import os
+import struct
+import sys
+
+RECORDS = {
+    0x01: ("samples", "<IIBf", ["timestamp_us", "raw_count", "status", "normalized_pressure"]),
+    0x02: ("omwe_points", "<Iff", ["timestamp_ms", "pressure", "amplitude"]),
+    0x03: ("bp_result", "<fffff", ["systolic", "diastolic", "map", "systolic_deviation", "diastolic_deviation"]),
+    0x04: ("pulse", "<fI", ["pulse_bpm", "pulse_data_count"]),
+}
+SESSION_RECORD = 0x05
+TEXT_RECORD = 0x10
+
+
+def crc16_ccitt_false(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_decode(encoded):
+    decoded = bytearray()
+    index = 0
+    while index < len(encoded):
+        code = encoded[index]
+        if code == 0 or index + code > len(encoded):
+            raise ValueError("corrupt COBS block")
+        decoded += encoded[index + 1:index + code]
+        index += code
+        if code != 0xFF and index < len(encoded):
+            decoded.append(0)
+    return bytes(decoded)
+
+
+def frames(stream):
+    """Yields the content of every 0x00 delimited frame of a byte stream."""
+    pending = bytearray()
+    while True:
+        chunk = stream.read(4096)
+        if not chunk:
+            break
+        pending += chunk
+        while True:
+            end = pending.find(b"\x00")
+            if end < 0:
+                break
+            yield bytes(pending[:end])
+            del pending[:end + 1]
+
+
+def decode(stream, out_dir, raw_copy=None):
+    os.makedirs(out_dir, exist_ok=True)
+    writers = {}
+    files = []
+    text = open(os.path.join(out_dir, "console.txt"), "w")
+    files.append(text)
+    stats = {"frames": 0, "bad_frames": 0}
+    session = bytearray()
+
+    def writer_for(record_type):
+        if record_type not in writers:
+            name, _, columns = RECORDS[record_type]
+            handle = open(os.path.join(out_dir, name + ".csv"), "w", newline="")
+            files.append(handle)
+            writers[record_type] = csv.writer(handle)
+            writers[record_type].writerow(columns)
+        return writers[record_type]
+
+    if raw_copy is not None:
+        original_read = stream.read
+
+        def copying_read(size):
+            data = original_read(size)
+            raw_copy.write(data)
+            return data
+        stream.read = copying_read
+
+    for frame in frames(stream):
+        if not frame:
+            continue
+        stats["frames"] += 1
+        try:
+            record = cobs_decode(frame)
+        except ValueError:
+            stats["bad_frames"] += 1
+            continue
+        if len(record) < 3 or crc16_ccitt_false(record[:-2]) != struct.unpack("<H", record[-2:])[0]:
+            stats["bad_frames"] += 1
+            continue
+        record_type, payload = record[0], record[1:-2]
+        if record_type == TEXT_RECORD:
+            text.write(payload.decode("ascii", errors="replace"))
+        elif record_type == SESSION_RECORD and len(payload) >= 4:
+            offset = struct.unpack("<I", payload[:4])[0]
+            chunk = payload[4:]
+            if len(session) < offset + len(chunk):
+                session += bytes(offset + len(chunk) - len(session))
+            session[offset:offset + len(chunk)] = chunk
+        elif record_type in RECORDS and len(payload) == struct.calcsize(RECORDS[record_type][1]):
+            writer_for(record_type).writerow(struct.unpack(RECORDS[record_type][1], payload))
+        else:
+            stats["bad_frames"] += 1
+
+    for handle in files:
+        handle.close()
+    if session:
+        with open(os.path.join(out_dir, "session.bps"), "wb") as handle:
+            handle.write(session)
+    return stats
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the binary telemetry stream of the blood pressure monitor")
+    parser.add_argument("input", nargs="?", help="recorded stream (default: stdin)")
+    parser.add_argument("--serial", help="read from this serial port instead of a file (needs pyserial)")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--out-dir", default="telemetry_out", help="directory for the CSV files")
+    parser.add_argument("--raw", help="also save the undecoded stream to this file")
+    args = parser.parse_args()
+
+    if args.serial:
+        import serial
+        stream = serial.Serial(args.serial, args.baud, timeout=None)
+    elif args.input:
+        stream = open(args.input, "rb")
+    else:
+        stream = sys.stdin.buffer
+    raw_copy = open(args.raw, "wb") if args.raw else None
+    try:
+        stats = decode(stream, args.out_dir, raw_copy)
+    except KeyboardInterrupt:
+        stats = None
+    finally:
+        if raw_copy is not None:
+            raw_copy.close()
+    if stats is not None:
+        print("frames = %d, rejected = %d" % (stats["frames"], stats["bad_frames"]), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()